@@ -1,7 +1,20 @@
 /* Unity build for ds */
+
+/* POSIX/GNU feature macros must come before the first system header and
+   are defined only here: vector.c needs mmap, ftruncate and mremap, fdict.c
+   mmap and fstat, cdict.c pthread rwlocks, dcache.c clock_gettime. */
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#elif !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
 #include "src/big_integer.c"
 #include "src/bst.c"
+#include "src/cdict.c"
+#include "src/dcache.c"
 #include "src/dictionary.c"
+#include "src/fdict.c"
 #include "src/fraction.c"
 #include "src/heap.c"
 #include "src/ordered_array.c"
@@ -12,4 +25,5 @@
 #include "src/sparse_set.c"
 #include "src/stack.c"
 #include "src/vector.c"
+#include "src/vector_spsc.c"
 #include "src/xor_list.c"
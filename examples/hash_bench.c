@@ -0,0 +1,109 @@
+/* Throughput of the fast unkeyed hashes against keyed SipHash-1-3.
+
+   Build (POSIX, from the repository root):
+     cc -std=c11 -O2 -pthread -Iinclude ds_all.c examples/hash_bench.c -o hash_bench
+   Run:
+     ./hash_bench [keys]      (default 1000000)
+
+   Each line times inserting every key once and then looking every key up
+   once, for 16-byte and 64-byte keys. */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "ds.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/* n pseudo-random alphanumeric keys of exactly len characters (xorshift64,
+   fixed seed, so runs are comparable; duplicates are possible but rare). */
+static char **make_keys(size_t n, size_t len) {
+    static const char alphabet[] =
+        "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+    unsigned long long x = 0x9E3779B97F4A7C15ull;
+    char **keys = (char**)malloc(n * sizeof(char*));
+    if (!keys) {
+        return NULL;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        keys[i] = (char*)malloc(len + 1);
+        if (!keys[i]) {
+            exit(1);
+        }
+        for (size_t j = 0; j < len; ++j) {
+            x ^= x << 13;
+            x ^= x >> 7;
+            x ^= x << 17;
+            keys[i][j] = alphabet[x % (sizeof(alphabet) - 1)];
+        }
+        keys[i][len] = '\0';
+    }
+    return keys;
+}
+
+static void free_keys(char **keys, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        free(keys[i]);
+    }
+    free(keys);
+}
+
+static void bench_dict(const char *label, int mode, char **keys, size_t n) {
+    dict *d = new_dict_with_hash(mode);
+    const char *v;
+    size_t hits = 0;
+    double t0 = now_sec();
+    for (size_t i = 0; i < n; ++i) {
+        dict_insert(d, keys[i], "v");
+    }
+    double t1 = now_sec();
+    for (size_t i = 0; i < n; ++i) {
+        hits += (dict_get(d, keys[i], &v) == DICT_OK);
+    }
+    double t2 = now_sec();
+    printf("  dict %-8s insert %7.1f Mops/s   get %7.1f Mops/s   (%zu hits)\n", label,
+           (double)n / (t1 - t0) * 1e-6, (double)n / (t2 - t1) * 1e-6, hits);
+    dict_dispose(d);
+}
+
+static void bench_set(const char *label, int mode, char **keys, size_t n) {
+    set *s = set_new_with_hash(mode);
+    size_t hits = 0;
+    double t0 = now_sec();
+    for (size_t i = 0; i < n; ++i) {
+        set_insert(s, keys[i]);
+    }
+    double t1 = now_sec();
+    for (size_t i = 0; i < n; ++i) {
+        hits += set_contains(s, keys[i]);
+    }
+    double t2 = now_sec();
+    printf("  set  %-8s insert %7.1f Mops/s   get %7.1f Mops/s   (%zu hits)\n", label,
+           (double)n / (t1 - t0) * 1e-6, (double)n / (t2 - t1) * 1e-6, hits);
+    set_dispose(s);
+}
+
+int main(int argc, char **argv) {
+    size_t n = (argc > 1) ? strtoul(argv[1], NULL, 10) : 1000000u;
+    const size_t lens[] = { 16u, 64u };
+    for (size_t l = 0; l < sizeof(lens) / sizeof(lens[0]); ++l) {
+        char **keys = make_keys(n, lens[l]);
+        if (!keys) {
+            return 1;
+        }
+        printf("%zu keys of %zu bytes\n", n, lens[l]);
+        bench_dict("fast", DICT_HASH_FAST, keys, n);
+        bench_dict("siphash", DICT_HASH_SIPHASH, keys, n);
+        bench_set("poly", SET_HASH_POLY, keys, n);
+        bench_set("siphash", SET_HASH_SIPHASH, keys, n);
+        free_keys(keys, n);
+    }
+    return 0;
+}
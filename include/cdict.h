@@ -0,0 +1,59 @@
+#ifndef DS_CDICT_H
+#define DS_CDICT_H
+
+/* Public interface for a thread-safe string->string dictionary.
+   Keys are partitioned by hash into a power-of-two number of shards; each
+   shard is an ordinary dict guarded by its own reader/writer lock, so
+   readers never block each other and writers only block their own shard.
+   Lookups copy the value out while the shard is locked: a pointer into the
+   dictionary would be unsafe once another thread may modify it.
+   All operations return explicit status codes; no diagnostic printing is performed. */
+
+#include <stddef.h>   /* size_t */
+#include <stdbool.h>  /* bool */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ---- Status codes ------------------------------------------------------- */
+#define CDICT_OK            0
+#define CDICT_ERR_OOM      -2
+#define CDICT_ERR_RANGE    -3   /* output buffer too small */
+#define CDICT_ERR_NOTFOUND -4
+
+/* Opaque handle */
+typedef struct cdict cdict;
+
+/* ---- Lifecycle ---------------------------------------------------------- */
+/* nshards is rounded up to a power of two; 0 picks a default (64). Use a few
+   shards per thread that touches the map. Returns NULL on allocation failure.
+   cdict_free must not race with any other call. */
+cdict  *cdict_new(size_t nshards);
+void    cdict_free(cdict *self);
+
+/* ---- Queries ------------------------------------------------------------ */
+/* Exact count at a single instant: takes every shard's read lock (in shard
+   order) before summing, so it excludes concurrent writers for its duration. */
+size_t  cdict_size(const cdict *self);
+size_t  cdict_shard_count(const cdict *self);
+bool    cdict_contains(const cdict *self, const char *key);
+
+/* ---- Lookups ------------------------------------------------------------ */
+/* Copies the value and a terminating NUL into buf (buf_size bytes) and
+   stores its length (without NUL) in *out_len when non-NULL. Returns
+   CDICT_ERR_RANGE, with *out_len still set, if buf is too small; size the
+   buffer from *out_len and retry. */
+int     cdict_get(const cdict *self, const char *key, char *buf, size_t buf_size,
+                  size_t *out_len);
+
+/* ---- Mutations ---------------------------------------------------------- */
+/* Insert or replace (upsert). On success returns CDICT_OK. */
+int     cdict_insert(cdict *self, const char *key, const char *value);
+/* Deletes key if present. Returns CDICT_OK on success, CDICT_ERR_NOTFOUND otherwise. */
+int     cdict_del(cdict *self, const char *key);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* DS_CDICT_H */
@@ -0,0 +1,64 @@
+#ifndef DS_DCACHE_H
+#define DS_DCACHE_H
+
+/* Public interface for a bounded string->string cache built on dict.
+   Entries are evicted once the cache exceeds its entry or byte budget;
+   lookups, inserts and evictions are all O(1). Optional per-entry TTLs are
+   checked lazily on access and by a bounded sweep.
+   Not thread-safe.
+   All operations return explicit status codes; no diagnostic printing is performed. */
+
+#include <stddef.h>   /* size_t */
+#include <stdbool.h>  /* bool */
+#include <stdint.h>   /* uint64_t */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ---- Status codes ------------------------------------------------------- */
+#define DCACHE_OK            0
+#define DCACHE_ERR_OOM      -2
+#define DCACHE_ERR_RANGE    -3   /* entry larger than the byte budget */
+#define DCACHE_ERR_NOTFOUND -4   /* absent or expired */
+
+/* ---- Eviction policies -------------------------------------------------- */
+#define DCACHE_LRU   0   /* evict the least recently used entry */
+#define DCACHE_CLOCK 1   /* second chance: a hit only sets a bit, no list write */
+
+/* Opaque handle */
+typedef struct dcache dcache;
+
+/* ---- Lifecycle ---------------------------------------------------------- */
+/* max_entries / max_bytes of 0 mean unlimited. Bytes count key and value
+   lengths. Returns NULL on allocation failure or an unknown policy. */
+dcache *dcache_new(size_t max_entries, size_t max_bytes, int policy);
+void    dcache_free(dcache *self);
+
+/* ---- Queries ------------------------------------------------------------ */
+/* Counts may include expired entries not yet swept. */
+size_t  dcache_size(const dcache *self);
+size_t  dcache_bytes(const dcache *self);
+
+/* ---- Lookups ------------------------------------------------------------ */
+/* On a hit, marks the entry as recently used and points *out_value at the
+   stored value, valid until the next call that modifies the cache. An
+   expired entry is removed and reported as DCACHE_ERR_NOTFOUND. */
+int     dcache_get(dcache *self, const char *key, const char **out_value);
+
+/* ---- Mutations ---------------------------------------------------------- */
+/* Insert or replace (upsert), then evict down to the budgets. ttl_ms is the
+   lifetime in milliseconds of a monotonic clock; 0 means no expiry. */
+int     dcache_put(dcache *self, const char *key, const char *value, uint64_t ttl_ms);
+/* Returns DCACHE_OK on success, DCACHE_ERR_NOTFOUND otherwise. */
+int     dcache_del(dcache *self, const char *key);
+
+/* Examines up to max_visits entries, oldest first, continuing where the
+   previous sweep stopped, and removes the expired ones. dcache_put already
+   runs a short sweep while TTL entries exist. Returns the number removed. */
+size_t  dcache_sweep(dcache *self, size_t max_visits);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* DS_DCACHE_H */
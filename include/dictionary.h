@@ -2,10 +2,13 @@
 #define DS_DICTIONARY_H
 
 /* Public interface for a string->string hash dictionary (open addressing).
+   Keys and values are byte strings: the *_n variants take explicit lengths
+   and accept binary data; the plain variants take NUL-terminated strings.
    All operations return explicit status codes; no diagnostic printing is performed. */
 
 #include <stddef.h>   /* size_t */
 #include <stdbool.h>  /* bool */
+#include <stdint.h>   /* uint64_t */
 
 #ifdef __cplusplus
 extern "C" {
@@ -16,28 +19,159 @@ extern "C" {
 #define DICT_ERR_OOM      -2
 #define DICT_ERR_NOTFOUND -4
 
+/* ---- Hash modes --------------------------------------------------------- */
+#define DICT_HASH_FAST    0   /* unkeyed 64-bit mix (default; fastest) */
+#define DICT_HASH_SIPHASH 1   /* SipHash-1-3, random secret key per dictionary */
+
 /* Opaque handle */
 typedef struct dictionary dict;
 
 /* ---- Lifecycle ---------------------------------------------------------- */
 dict   *new_dict(void);                 /* Returns NULL on allocation failure */
+/* Sized so that n entries fit without any rehash (a single table
+   allocation); the table also never shrinks below that size. */
+dict   *new_dict_with_capacity(size_t n);
+/* Picks the key hash. Use DICT_HASH_SIPHASH when keys come from untrusted
+   sources: with the fast hash, chosen keys can all land in one probe chain
+   and make every operation O(n). Returns NULL for an unknown mode. */
+dict   *new_dict_with_hash(int mode);
 void    dict_dispose(dict *self);
+/* Like new_dict, but key/value bytes come from an internal slab arena with
+   free-list reuse instead of one malloc per string. dict_dispose releases
+   the arena chunks in bulk without visiting entries. */
+dict   *dict_new_arena(void);
+
+/* ---- Rehashing mode ----------------------------------------------------- */
+/* When enabled, a resize keeps the old table and each later insert/delete
+   migrates a bounded number of buckets, so no single call pays for a full
+   rehash. Lookups check both tables until migration finishes. Disabling
+   finishes any pending migration immediately. Off by default. */
+void    dict_set_incremental_rehash(dict *self, bool enable);
+bool    dict_is_rehashing(const dict *self);
 
 /* ---- Queries ------------------------------------------------------------ */
 size_t  dict_size(const dict *self);    /* number of stored key/value pairs */
 bool    dict_contains(const dict *self, const char *key);
 
+/* ---- Iteration ---------------------------------------------------------- */
+/* Visits every entry once, in unspecified order. Start with *cursor = 0;
+   each call stores the next entry (any out pointer may be NULL) and returns
+   true, or returns false when done. The dictionary must not be modified
+   while iterating. Returned pointers are owned by the dictionary. */
+bool    dict_next(const dict *self, size_t *cursor, const char **out_key, size_t *out_klen,
+                  const char **out_value, size_t *out_vlen);
+
 /* ---- Lookups ------------------------------------------------------------ */
 /* On success, writes a pointer to the stored value into *out_value and returns DICT_OK.
    The returned pointer remains owned by the dictionary; do not free it. */
 int     dict_get(const dict *self, const char *key, const char **out_value);
+/* Binary-key lookup. The stored value is followed by a NUL for convenience;
+   its exact length is written to *out_vlen when non-NULL. */
+int     dict_get_n(const dict *self, const void *key, size_t klen,
+                   const char **out_value, size_t *out_vlen);
+/* Batched lookup of n NUL-terminated keys. For each i, out_values[i] gets the
+   stored value (NULL if absent) and out_found[i] whether keys[i] was found;
+   either array may be NULL. Keys are hashed and their buckets prefetched
+   ahead of probing, which is faster than n dict_get calls for large tables.
+   Returns the number of keys found. */
+size_t  dict_get_many(const dict *self, const char *const *keys, size_t n,
+                      const char **out_values, bool *out_found);
 
 /* ---- Mutations ---------------------------------------------------------- */
 /* Insert or replace (upsert). On success returns DICT_OK. */
 int     dict_insert(dict *self, const char *key, const char *value);
+int     dict_insert_n(dict *self, const void *key, size_t klen,
+                      const void *value, size_t vlen);
+
+/* Single-probe read-modify-write. Both find the key or its insertion slot
+   in one probe sequence. Values are rewritten in place whenever the new
+   bytes fit the existing allocation, so unchanged-size updates never
+   allocate. */
+
+/* Returns the stored value of key in *out_value, first inserting a copy of
+   default_value if key is absent (*out_inserted tells which; either out
+   pointer may be NULL). The value bytes may be overwritten in place
+   through *out_value, but its length must stay the same (the stored length
+   is not re-read; use dict_update to change it). The pointer is valid
+   until the next mutation. Returns DICT_OK or DICT_ERR_OOM. */
+int     dict_get_or_insert(dict *self, const char *key, const char *default_value,
+                           char **out_value, bool *out_inserted);
+
+/* Called with the current value (NULL if key is absent) and *vlen set to
+   its length in bytes (0 if absent), so binary values are seen whole.
+   Returns the new value and stores its length in *vlen; the dictionary
+   copies that many bytes. The result may be current itself after editing
+   it in place without growing it. Returning NULL leaves the dictionary
+   unchanged. Must not modify the dictionary. */
+typedef const char *(*dict_update_fn)(const char *key, const char *current,
+                                      size_t *vlen, void *ctx);
+
+/* Inserts or replaces key's value with fn's result.
+   Returns DICT_OK or DICT_ERR_OOM. */
+int     dict_update(dict *self, const char *key, dict_update_fn fn, void *ctx);
 
 /* Deletes key if present. Returns DICT_OK on success, DICT_ERR_NOTFOUND otherwise. */
 int     dict_del(dict *self, const char *key);
+int     dict_del_n(dict *self, const void *key, size_t klen);
+
+/* ---- Ownership transfer ------------------------------------------------- */
+/* Like dict_insert, but adopts key and value: both must be NUL-terminated
+   malloc'd buffers, and on DICT_OK the dictionary owns (and eventually
+   frees) them. If key is already present its stored key is kept and the
+   passed key is freed. On failure the caller still owns both. Arena
+   dictionaries copy the bytes into the arena and free the buffers, so
+   there the call saves nothing over dict_insert. */
+int     dict_insert_owned(dict *self, char *key, char *value);
+
+/* Removes key and hands its buffers to the caller instead of freeing
+   them: *out_key and *out_value receive malloc'd NUL-terminated strings
+   that the caller must free (pass NULL for either to have it freed here).
+   Arena dictionaries return malloc'd copies. Returns DICT_OK,
+   DICT_ERR_NOTFOUND, or DICT_ERR_OOM (arena copy failed; entry kept). */
+int     dict_take(dict *self, const char *key, char **out_key, char **out_value);
+
+/* ---- Prehashed access -------------------------------------------------- */
+/* For layers that already hash the key (e.g. to pick a shard): h must be
+   dict_hash(self, key, klen), or the same value from another dictionary
+   with the same hash mode and key (all DICT_HASH_FAST dictionaries agree).
+   The *_hashed calls behave like their *_n counterparts but skip hashing;
+   a wrong h makes the key unreachable. */
+uint64_t dict_hash(const dict *self, const void *key, size_t klen);
+int     dict_get_hashed(const dict *self, const void *key, size_t klen, uint64_t h,
+                        const char **out_value, size_t *out_vlen);
+int     dict_insert_hashed(dict *self, const void *key, size_t klen, uint64_t h,
+                           const void *value, size_t vlen);
+int     dict_del_hashed(dict *self, const void *key, size_t klen, uint64_t h);
+
+/* Removes all tombstones left by deletions, in place and without changing
+   the bucket count. Inserts also do this automatically once live entries
+   plus tombstones pass 85% of the buckets. Returns DICT_OK
+   (DICT_ERR_NOTFOUND for a NULL dictionary). */
+int     dict_compact(dict *self);
+
+/* ---- Statistics ------------------------------------------------------- */
+#define DICT_STATS_HIST 16
+
+/* Probe lengths count 16-slot control groups visited, 1 meaning the key's
+   home group. Computing them walks the whole table: O(buckets). */
+struct dict_stats {
+    size_t live;            /* stored entries */
+    size_t tombstones;      /* deleted markers still occupying buckets */
+    size_t capacity;        /* buckets (both tables while rehashing) */
+    size_t probe_hist[DICT_STATS_HIST]; /* [k]: entries found in group k+1; last bin is >= */
+    size_t max_probe;       /* longest successful probe */
+    double avg_hit_probe;   /* mean groups visited by a successful lookup */
+    double avg_miss_probe;  /* mean groups visited by an unsuccessful lookup */
+    size_t bucket_bytes;    /* control bytes */
+    size_t item_bytes;      /* slot array (hash, lengths, pointers) */
+    size_t string_bytes;    /* key/value payload including NULs */
+    size_t arena_bytes;     /* memory held by the string arena (0 without one) */
+    size_t resizes;         /* table reallocations; counted only when built with DS_STATS */
+};
+
+/* Fills *out (the struct tag is separate from the function name).
+   Returns DICT_OK (DICT_ERR_NOTFOUND for NULL arguments). */
+int     dict_stats(const dict *self, struct dict_stats *out);
 
 /* ---- Debug -------------------------------------------------------------- */
 /* Optional helper to print basic stats or dump contents (implementation-defined). */
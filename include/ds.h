@@ -7,7 +7,10 @@ extern "C" {
 
 #include "big_integer.h"
 #include "bst.h"
+#include "cdict.h"
+#include "dcache.h"
 #include "dictionary.h"
+#include "fdict.h"
 #include "fraction.h"
 #include "heap.h"
 #include "ordered_array.h"
@@ -18,6 +21,7 @@ extern "C" {
 #include "sparse_set.h"
 #include "stack.h"
 #include "vector.h"
+#include "vector_spsc.h"
 #include "xor_list.h"
 
 #ifdef __cplusplus
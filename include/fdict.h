@@ -0,0 +1,58 @@
+#ifndef DS_FDICT_H
+#define DS_FDICT_H
+
+/* Public interface for frozen dictionaries: a read-only, on-disk image of a
+   dict that is opened with mmap and queried in place.
+   dict_freeze writes the image; it indexes the keys with a minimal perfect
+   hash (CHD, hash-and-displace), so a lookup is one hash, one slot read and
+   one key comparison, with no allocation and no probing. Opening an image
+   validates every slot record, so its cost is linear in the number of keys.
+   Images use the writer's byte order and are not portable across endianness.
+   All operations return explicit status codes; no diagnostic printing is performed. */
+
+#include <stddef.h>   /* size_t */
+#include <stdbool.h>  /* bool */
+#include "dictionary.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ---- Status codes ------------------------------------------------------- */
+#define FDICT_OK            0
+#define FDICT_ERR_OOM      -2
+#define FDICT_ERR_NOTFOUND -4
+#define FDICT_ERR_IO       -9   /* open/write failure or invalid image */
+
+/* Opaque handle */
+typedef struct fdict fdict;
+
+/* ---- Building ----------------------------------------------------------- */
+/* Writes every entry of d to a new image at path. The image is written to
+   path + ".tmp" and renamed over path, so processes that still have the
+   old image open keep a valid mapping and a failed write leaves any
+   existing file untouched. Returns FDICT_OK, FDICT_ERR_OOM, or FDICT_ERR_IO. */
+int     dict_freeze(const dict *d, const char *path);
+
+/* ---- Lifecycle ---------------------------------------------------------- */
+/* Maps an image written by dict_freeze. Returns NULL if the file cannot be
+   opened or is not a valid image (always NULL where mmap is unavailable). */
+fdict  *fdict_open(const char *path);
+void    fdict_close(fdict *f);
+
+/* ---- Queries ------------------------------------------------------------ */
+size_t  fdict_size(const fdict *f);
+bool    fdict_contains(const fdict *f, const char *key);
+
+/* ---- Lookups ------------------------------------------------------------ */
+/* On success, points *out_value into the mapping (NUL-terminated; valid until
+   fdict_close) and returns FDICT_OK; otherwise FDICT_ERR_NOTFOUND. */
+int     fdict_get(const fdict *f, const char *key, const char **out_value);
+/* Binary-key lookup; the exact value length goes to *out_vlen when non-NULL. */
+int     fdict_get_n(const fdict *f, const void *key, size_t klen,
+                    const char **out_value, size_t *out_vlen);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* DS_FDICT_H */
@@ -14,11 +14,19 @@ extern "C" {
 #define SET_ERR_NOTFOUND  -4
 #define SET_ERR_DUPLICATE -7
 
+/* ---- Hash modes --------------------------------------------------------- */
+#define SET_HASH_POLY    0   /* fixed polynomial hash (default) */
+#define SET_HASH_SIPHASH 1   /* SipHash-1-3, random secret key per set */
+
 /* Opaque handle */
 typedef struct set set;
 
 /* ---- Lifecycle ---------------------------------------------------------- */
 set   *set_new(void);
+/* Use SET_HASH_SIPHASH for keys from untrusted sources: the polynomial
+   hash is public, so chosen keys can share one probe chain. Returns NULL
+   for an unknown mode. */
+set   *set_new_with_hash(int mode);
 void   set_dispose(set *self);
 
 /* ---- Queries ------------------------------------------------------------ */
@@ -7,6 +7,7 @@
 
 #include <stddef.h>  /* size_t */
 #include <stdbool.h> /* bool */
+#include <stdint.h>  /* int64_t */
 
 #ifdef __cplusplus
 extern "C" {
@@ -18,14 +19,33 @@ extern "C" {
 #define VECTOR_ERR_OOM      -2
 #define VECTOR_ERR_RANGE    -3
 #define VECTOR_ERR_NOTFOUND -4
+#define VECTOR_ERR_FULL     -5  /* fixed-capacity variants (vector_spsc) */
+#define VECTOR_ERR_IO       -6
 
 /* Opaque handle */
 typedef struct vector vector;
 
 /* ---- Lifecycle ---------------------------------------------------------- */
 vector *vector_new(void);            /* Returns NULL on allocation failure */
+/* Sizes the buffer once for at least `capacity` elements. Small capacities
+   live inline in the header allocation, so such a vector costs one malloc. */
+vector *vector_new_with_capacity(size_t capacity);
 void    vector_free(vector *v);
 
+/* ---- File-backed vectors ------------------------------------------------ */
+/* Opens (or with VECTOR_MAP_CREATE creates) a vector whose ring buffer lives
+   in an mmap'd file, behind a small header holding head/size/capacity.
+   Growth extends the file with ftruncate and remaps it. vector_free unmaps
+   and closes; the header is written back by vector_sync and vector_free.
+   Returns NULL on I/O failure, on a malformed file, or where mmap is not
+   available (Windows). */
+#define VECTOR_MAP_CREATE   0x1
+#define VECTOR_MAP_TRUNCATE 0x2   /* discard existing contents */
+
+vector *vector_open_mapped(const char *path, int flags);
+/* Writes the header and flushes the mapping (msync). No-op for memory-only vectors. */
+int     vector_sync(vector *v);   /* OK or IO */
+
 /* ---- Capacity control --------------------------------------------------- */
 /* Grows capacity to at least min_capacity; never shrinks implicitly. */
 int     vector_reserve(vector *v, size_t min_capacity); /* OK or OOM */
@@ -50,10 +70,68 @@ int     vector_pop_back  (vector *v, int *out);
 int     vector_insert    (vector *v, size_t index, int value);  /* insert at [0..size] */
 int     vector_remove    (vector *v, size_t index, int *out);
 
+/* ---- Bulk removal ------------------------------------------------------- */
+/* Each runs a single stable pass over the ring segments. */
+typedef bool (*vector_pred_fn)(int value, void *ctx);
+
+size_t  vector_remove_if   (vector *v, vector_pred_fn pred, void *ctx); /* returns number removed */
+size_t  vector_remove_value(vector *v, int value);                      /* returns number removed */
+/* Removes logical [from, to), shifting whichever side is shorter; removes
+   to - from elements. RANGE if from > to or to > size. */
+int     vector_remove_range(vector *v, size_t from, size_t to);
+
+/* ---- Bulk transfer ------------------------------------------------------ */
+/* Each call grows capacity at most once and copies with at most two memcpy
+   calls across the ring's wrap point. */
+int     vector_push_back_n (vector *v, const int *src, size_t count);  /* appends src[0..count) */
+int     vector_push_front_n(vector *v, const int *src, size_t count);  /* src[0] becomes the front */
+/* Copies logical elements [start, start+count) into dst; RANGE if out of bounds. */
+int     vector_copy_out    (const vector *v, size_t start, size_t count, int *dst);
+/* Removes count elements from the front, copying them into dst unless dst is NULL.
+   RANGE if count exceeds the size (EMPTY when the vector is empty). */
+int     vector_pop_front_n (vector *v, size_t count, int *dst);
+
+/* ---- Views ------------------------------------------------------------- */
+/* Exposes the live elements as at most two contiguous spans in logical order:
+   [a, a+alen) followed by [b, b+blen). Unused spans are reported as NULL/0.
+   Pointers stay valid until the next operation that changes size or capacity. */
+void    vector_spans    (const vector *v, const int **a, size_t *alen,
+                         const int **b, size_t *blen);
+void    vector_spans_mut(vector *v, int **a, size_t *alen, int **b, size_t *blen);
+/* Rotates the ring in place (no allocation) so the elements occupy
+   data[0..size); optionally returns that pointer through out_data. */
+int     vector_make_contiguous(vector *v, int **out_data);
+
 /* ---- Search ------------------------------------------------------------- */
-/* On success writes logical index into *out_index and returns VECTOR_OK;
+/* Scans use SSE2/AVX2 kernels when the CPU supports them (x86, GCC/Clang),
+   otherwise a scalar loop.
+   On success writes logical index into *out_index and returns VECTOR_OK;
    returns VECTOR_ERR_NOTFOUND when the value does not occur. */
 int     vector_search(const vector *v, int value, size_t *out_index);
+/* Number of elements equal to value. */
+size_t  vector_count(const vector *v, int value);
+/* Writes up to max ascending logical indices of elements equal to value into
+   out_idx; returns how many were written. */
+size_t  vector_find_all(const vector *v, int value, size_t *out_idx, size_t max);
+
+/* ---- Aggregates and transforms ----------------------------------------- */
+/* Arithmetic helpers run SIMD kernels over the ring segments (same dispatch
+   as the search functions). vector_add_scalar wraps on overflow. */
+typedef int (*vector_map_fn)(int value, void *ctx);
+
+int64_t vector_sum       (const vector *v);                           /* 0 when empty */
+int     vector_min_max   (const vector *v, int *out_min, int *out_max); /* EMPTY when empty */
+int     vector_fill      (vector *v, int value);
+int     vector_add_scalar(vector *v, int delta);
+/* Replaces every element x with fn(x, ctx), segment by segment in logical order. */
+int     vector_map       (vector *v, vector_map_fn fn, void *ctx);
+
+/* ---- Sorting ------------------------------------------------------------ */
+/* Sorts ascending with an LSD radix sort; needs a scratch buffer of size n. */
+int     vector_sort(vector *v);                          /* OK or OOM */
+/* Radix-sorts up to nthreads slices on pthreads, then merges them pairwise in
+   parallel. Small inputs and builds without pthreads use vector_sort. */
+int     vector_sort_parallel(vector *v, unsigned nthreads); /* OK or OOM */
 
 /* ---- Debug -------------------------------------------------------------- */
 /* Convenience helper for ad-hoc inspection; not used for error reporting. */
@@ -0,0 +1,44 @@
+#ifndef DS_VECTOR_SPSC_H
+#define DS_VECTOR_SPSC_H
+
+/* Public interface for a fixed-capacity, lock-free single-producer /
+   single-consumer integer ring (the vector ring buffer without growth).
+   Exactly one thread may call the producer functions (push_back*) and
+   exactly one thread the consumer functions (pop_front*) concurrently.
+   Status codes are shared with vector.h. */
+
+#include <stddef.h>  /* size_t */
+#include "vector.h"  /* VECTOR_OK, VECTOR_ERR_* */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Opaque handle */
+typedef struct vector_spsc vector_spsc;
+
+/* ---- Lifecycle ---------------------------------------------------------- */
+/* Capacity is rounded up to a power of two. NULL on allocation failure. */
+vector_spsc *vector_spsc_new(size_t capacity);
+void         vector_spsc_free(vector_spsc *q);
+
+/* ---- Queries ------------------------------------------------------------ */
+size_t  vector_spsc_capacity(const vector_spsc *q);
+/* Exact when called from either endpoint thread with the other one idle;
+   otherwise a snapshot that may be stale by the time it returns. */
+size_t  vector_spsc_size(const vector_spsc *q);
+
+/* ---- Producer ----------------------------------------------------------- */
+int     vector_spsc_push_back(vector_spsc *q, int value);             /* OK or FULL */
+/* Enqueues up to count elements; returns how many were enqueued. */
+size_t  vector_spsc_push_back_n(vector_spsc *q, const int *src, size_t count);
+
+/* ---- Consumer ----------------------------------------------------------- */
+int     vector_spsc_pop_front(vector_spsc *q, int *out);              /* OK or EMPTY */
+/* Dequeues up to max elements into dst; returns how many were dequeued. */
+size_t  vector_spsc_pop_front_n(vector_spsc *q, int *dst, size_t max);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* DS_VECTOR_SPSC_H */
@@ -0,0 +1,236 @@
+#include "cdict.h"
+#include "dictionary.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+typedef SRWLOCK cdict_lock;
+#define CDICT_LOCK_INIT(l)    (InitializeSRWLock(l), 0)
+#define CDICT_LOCK_DESTROY(l) ((void)(l))
+#define CDICT_RDLOCK(l)       AcquireSRWLockShared(l)
+#define CDICT_RDUNLOCK(l)     ReleaseSRWLockShared(l)
+#define CDICT_WRLOCK(l)       AcquireSRWLockExclusive(l)
+#define CDICT_WRUNLOCK(l)     ReleaseSRWLockExclusive(l)
+#else
+#include <pthread.h>
+typedef pthread_rwlock_t cdict_lock;
+#define CDICT_LOCK_INIT(l)    pthread_rwlock_init((l), NULL)
+#define CDICT_LOCK_DESTROY(l) pthread_rwlock_destroy(l)
+#define CDICT_RDLOCK(l)       pthread_rwlock_rdlock(l)
+#define CDICT_RDUNLOCK(l)     pthread_rwlock_unlock(l)
+#define CDICT_WRLOCK(l)       pthread_rwlock_wrlock(l)
+#define CDICT_WRUNLOCK(l)     pthread_rwlock_unlock(l)
+#endif
+
+/* Layout:
+   - An array of shards, each {lock, dict}. A key's shard is taken from the
+     top bits of its 64-bit hash; the dict inside uses the low bits for its
+     own buckets, so the two choices stay independent. The key is hashed
+     once: the same hash goes to the shard's dict through the *_hashed
+     calls (every shard is a DICT_HASH_FAST dict, so dict_hash agrees).
+   - Each shard starts on its own cache line (the array itself is aligned by
+     hand, since malloc only guarantees 16 bytes), so readers bumping one
+     shard's lock word never invalidate a neighbour's.
+   - Readers share a shard (dict_get never mutates, even while an
+     incremental rehash is pending); inserts and deletes take it exclusively.
+   - cdict_size read-locks all shards in index order; writers hold at most
+     one lock at a time, so the ordering cannot deadlock. */
+
+#define CDICT_CACHE_LINE      64u
+#define CDICT_DEFAULT_SHARDS  64u
+
+typedef struct cdict_shard {
+    _Alignas(CDICT_CACHE_LINE) cdict_lock lock;
+    dict *map;
+} cdict_shard;
+
+struct cdict {
+    cdict_shard *shards;  /* aligned view into raw */
+    void        *raw;     /* allocation backing shards */
+    size_t       count;   /* power of two */
+    unsigned     shift;   /* 64 - log2(count); hash >> shift = shard index */
+};
+
+/* ---- internal helpers --------------------------------------------------- */
+
+static cdict_shard *cdict_shard_of(const cdict *self, uint64_t h) {
+    /* shift by 64 is undefined, so a single shard always uses index 0 */
+    size_t i = self->count > 1 ? (size_t)(h >> self->shift) : 0;
+    return &self->shards[i];
+}
+
+static void cdict_release(cdict *self, size_t ready) {
+    for (size_t i = 0; i < ready; ++i) {
+        CDICT_LOCK_DESTROY(&self->shards[i].lock);
+        dict_dispose(self->shards[i].map);
+    }
+    free(self->raw);
+    free(self);
+}
+
+/* ---- Lifecycle ---------------------------------------------------------- */
+
+cdict *cdict_new(size_t nshards) {
+    if (nshards == 0) {
+        nshards = CDICT_DEFAULT_SHARDS;
+    }
+    size_t count = 1;
+    unsigned bits = 0;
+    while (count < nshards) {
+        if (bits == 32) {
+            return NULL; /* absurd shard count */
+        }
+        else {
+            count <<= 1;
+            ++bits;
+        }
+    }
+
+    cdict *self = (cdict*)malloc(sizeof(cdict));
+    if (!self) {
+        return NULL;
+    }
+    self->count = count;
+    self->shift = 64u - bits;
+    self->raw = malloc(count * sizeof(cdict_shard) + CDICT_CACHE_LINE - 1);
+    if (!self->raw) {
+        free(self);
+        return NULL;
+    }
+    else {
+        uintptr_t p = ((uintptr_t)self->raw + CDICT_CACHE_LINE - 1) & ~(uintptr_t)(CDICT_CACHE_LINE - 1);
+        self->shards = (cdict_shard*)p;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        cdict_shard *s = &self->shards[i];
+        s->map = new_dict();
+        if (!s->map) {
+            cdict_release(self, i);
+            return NULL;
+        }
+        else if (CDICT_LOCK_INIT(&s->lock) != 0) {
+            dict_dispose(s->map);
+            cdict_release(self, i);
+            return NULL;
+        }
+    }
+    return self;
+}
+
+void cdict_free(cdict *self) {
+    if (!self) {
+        return;
+    }
+    else {
+        cdict_release(self, self->count);
+    }
+}
+
+/* ---- Queries ------------------------------------------------------------ */
+
+size_t cdict_size(const cdict *self) {
+    if (!self) {
+        return 0;
+    }
+    else {
+        size_t n = 0;
+        for (size_t i = 0; i < self->count; ++i) {
+            CDICT_RDLOCK(&self->shards[i].lock);
+        }
+        for (size_t i = 0; i < self->count; ++i) {
+            n += dict_size(self->shards[i].map);
+        }
+        for (size_t i = self->count; i > 0; --i) {
+            CDICT_RDUNLOCK(&self->shards[i - 1].lock);
+        }
+        return n;
+    }
+}
+
+size_t cdict_shard_count(const cdict *self) {
+    return self ? self->count : 0;
+}
+
+bool cdict_contains(const cdict *self, const char *key) {
+    if (!self || !key) {
+        return false;
+    }
+    else {
+        size_t klen = strlen(key);
+        uint64_t h = dict_hash(self->shards[0].map, key, klen);
+        cdict_shard *s = cdict_shard_of(self, h);
+        CDICT_RDLOCK(&s->lock);
+        bool found = dict_get_hashed(s->map, key, klen, h, NULL, NULL) == DICT_OK;
+        CDICT_RDUNLOCK(&s->lock);
+        return found;
+    }
+}
+
+/* ---- Lookups ------------------------------------------------------------ */
+
+int cdict_get(const cdict *self, const char *key, char *buf, size_t buf_size,
+              size_t *out_len) {
+    if (!self || !key) {
+        return CDICT_ERR_NOTFOUND;
+    }
+    else {
+        size_t klen = strlen(key);
+        uint64_t h = dict_hash(self->shards[0].map, key, klen);
+        cdict_shard *s = cdict_shard_of(self, h);
+        const char *v = NULL;
+        size_t vlen = 0;
+        int rc;
+        CDICT_RDLOCK(&s->lock);
+        if (dict_get_hashed(s->map, key, klen, h, &v, &vlen) != DICT_OK) {
+            rc = CDICT_ERR_NOTFOUND;
+        }
+        else if (!buf || buf_size <= vlen) {
+            rc = CDICT_ERR_RANGE;
+        }
+        else {
+            memcpy(buf, v, vlen + 1); /* stored values carry a NUL */
+            rc = CDICT_OK;
+        }
+        CDICT_RDUNLOCK(&s->lock);
+        if (out_len && rc != CDICT_ERR_NOTFOUND) {
+            *out_len = vlen;
+        }
+        return rc;
+    }
+}
+
+/* ---- Mutations ---------------------------------------------------------- */
+
+int cdict_insert(cdict *self, const char *key, const char *value) {
+    if (!self || !key || !value) {
+        return CDICT_ERR_OOM; /* treat as failure, as dict_insert does */
+    }
+    else {
+        size_t klen = strlen(key);
+        uint64_t h = dict_hash(self->shards[0].map, key, klen);
+        cdict_shard *s = cdict_shard_of(self, h);
+        CDICT_WRLOCK(&s->lock);
+        int rc = dict_insert_hashed(s->map, key, klen, h, value, strlen(value));
+        CDICT_WRUNLOCK(&s->lock);
+        return rc == DICT_OK ? CDICT_OK : CDICT_ERR_OOM;
+    }
+}
+
+int cdict_del(cdict *self, const char *key) {
+    if (!self || !key) {
+        return CDICT_ERR_NOTFOUND;
+    }
+    else {
+        size_t klen = strlen(key);
+        uint64_t h = dict_hash(self->shards[0].map, key, klen);
+        cdict_shard *s = cdict_shard_of(self, h);
+        CDICT_WRLOCK(&s->lock);
+        int rc = dict_del_hashed(s->map, key, klen, h);
+        CDICT_WRUNLOCK(&s->lock);
+        return rc == DICT_OK ? CDICT_OK : CDICT_ERR_NOTFOUND;
+    }
+}
@@ -0,0 +1,334 @@
+#include "dcache.h"
+#include "dictionary.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+/* Layout:
+   - A dict maps each key to its node; the dict value is the node pointer
+     stored as sizeof(void*) raw bytes (dict_insert_n).
+   - Nodes sit on one intrusive doubly linked list, newest at head. The
+     node carries its own key copy so eviction can delete it from the dict.
+   - LRU moves a node to the head on every hit and evicts the tail.
+   - CLOCK only sets node->referenced on a hit. Eviction looks at the tail:
+     a referenced node loses its bit and moves to the head (second chance),
+     the first unreferenced one is evicted. Read hits never touch the list.
+   - Expiry uses a millisecond monotonic clock; expires == 0 means never.
+     The sweep cursor walks from tail to head in bounded steps and wraps;
+     unlinking the node under the cursor moves the cursor to its neighbour. */
+
+typedef struct dcache_node {
+    struct dcache_node *prev;   /* toward head (newer) */
+    struct dcache_node *next;   /* toward tail (older) */
+    uint64_t expires;           /* monotonic ms; 0 = no TTL */
+    char    *value;             /* vlen bytes + NUL */
+    size_t   vlen;
+    size_t   klen;
+    bool     referenced;        /* CLOCK hit bit */
+    char     key[];             /* klen bytes + NUL */
+} dcache_node;
+
+struct dcache {
+    dict        *map;
+    dcache_node *head;
+    dcache_node *tail;
+    dcache_node *sweep;         /* next node to examine; NULL = start at tail */
+    size_t       count;
+    size_t       bytes;         /* sum of klen + vlen */
+    size_t       ttl_count;     /* entries with an expiry */
+    size_t       max_entries;   /* 0 = unlimited */
+    size_t       max_bytes;     /* 0 = unlimited */
+    int          policy;
+};
+
+#define DCACHE_SWEEP_STEP 8u    /* nodes examined by each dcache_put */
+#define DCACHE_PRESIZE    1024u /* most entries the map is presized for */
+
+/* ---- internal helpers --------------------------------------------------- */
+
+static uint64_t dcache_now_ms(void) {
+#if defined(_WIN32)
+    return (uint64_t)GetTickCount64();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
+#endif
+}
+
+static bool dcache_expired(const dcache_node *n, uint64_t now) {
+    return n->expires != 0 && now >= n->expires;
+}
+
+static void dcache_unlink(dcache *self, dcache_node *n) {
+    if (self->sweep == n) {
+        self->sweep = n->prev;
+    }
+    if (n->prev) {
+        n->prev->next = n->next;
+    }
+    else {
+        self->head = n->next;
+    }
+    if (n->next) {
+        n->next->prev = n->prev;
+    }
+    else {
+        self->tail = n->prev;
+    }
+    n->prev = NULL;
+    n->next = NULL;
+}
+
+static void dcache_push_front(dcache *self, dcache_node *n) {
+    n->prev = NULL;
+    n->next = self->head;
+    if (self->head) {
+        self->head->prev = n;
+    }
+    else {
+        self->tail = n;
+    }
+    self->head = n;
+}
+
+static dcache_node *dcache_find(const dcache *self, const char *key, size_t klen) {
+    const char *v = NULL;
+    size_t vlen = 0;
+    if (dict_get_n(self->map, key, klen, &v, &vlen) != DICT_OK || vlen != sizeof(dcache_node*)) {
+        return NULL;
+    }
+    else {
+        dcache_node *n;
+        memcpy(&n, v, sizeof(n));
+        return n;
+    }
+}
+
+static void dcache_remove(dcache *self, dcache_node *n) {
+    (void)dict_del_n(self->map, n->key, n->klen);
+    dcache_unlink(self, n);
+    self->count--;
+    self->bytes -= n->klen + n->vlen;
+    if (n->expires) {
+        self->ttl_count--;
+    }
+    free(n->value);
+    free(n);
+}
+
+/* Picks and removes one entry according to the policy, never keep (the
+   entry being inserted; an unreferenced newcomer would otherwise be CLOCK's
+   first victim once every older entry has used its second chance). */
+static void dcache_evict_one(dcache *self, const dcache_node *keep) {
+    if (self->policy == DCACHE_CLOCK) {
+        while (self->tail->referenced || self->tail == keep) {
+            dcache_node *n = self->tail;
+            n->referenced = false;
+            dcache_unlink(self, n);
+            dcache_push_front(self, n);
+        }
+    }
+    dcache_remove(self, self->tail);
+}
+
+static bool dcache_over_budget(const dcache *self) {
+    return (self->max_entries && self->count > self->max_entries) ||
+           (self->max_bytes && self->bytes > self->max_bytes);
+}
+
+static char *dcache_copy(const char *src, size_t n) {
+    char *p = (char*)malloc(n + 1);
+    if (p) {
+        memcpy(p, src, n + 1);
+    }
+    return p;
+}
+
+/* ---- Lifecycle ---------------------------------------------------------- */
+
+dcache *dcache_new(size_t max_entries, size_t max_bytes, int policy) {
+    if (policy != DCACHE_LRU && policy != DCACHE_CLOCK) {
+        return NULL;
+    }
+    dcache *self = (dcache*)calloc(1, sizeof(dcache));
+    if (!self) {
+        return NULL;
+    }
+    /* presize small caches only: new_dict_with_capacity also sets the
+       shrink floor, so a large budget would pin its whole table even
+       while the cache is nearly empty; bigger maps grow on demand */
+    self->map = new_dict_with_capacity(max_entries < DCACHE_PRESIZE ? max_entries : DCACHE_PRESIZE);
+    if (!self->map) {
+        free(self);
+        return NULL;
+    }
+    else {
+        self->max_entries = max_entries;
+        self->max_bytes = max_bytes;
+        self->policy = policy;
+        return self;
+    }
+}
+
+void dcache_free(dcache *self) {
+    if (!self) {
+        return;
+    }
+    else {
+        dcache_node *n = self->head;
+        while (n) {
+            dcache_node *next = n->next;
+            free(n->value);
+            free(n);
+            n = next;
+        }
+        dict_dispose(self->map);
+        free(self);
+    }
+}
+
+/* ---- Queries ------------------------------------------------------------ */
+
+size_t dcache_size(const dcache *self) {
+    return self ? self->count : 0;
+}
+
+size_t dcache_bytes(const dcache *self) {
+    return self ? self->bytes : 0;
+}
+
+/* ---- Lookups ------------------------------------------------------------ */
+
+int dcache_get(dcache *self, const char *key, const char **out_value) {
+    if (!self || !key) {
+        return DCACHE_ERR_NOTFOUND;
+    }
+    dcache_node *n = dcache_find(self, key, strlen(key));
+    if (!n) {
+        return DCACHE_ERR_NOTFOUND;
+    }
+    else if (n->expires && dcache_expired(n, dcache_now_ms())) {
+        dcache_remove(self, n);
+        return DCACHE_ERR_NOTFOUND;
+    }
+    else {
+        if (self->policy == DCACHE_CLOCK) {
+            n->referenced = true;
+        }
+        else if (self->head != n) {
+            dcache_unlink(self, n);
+            dcache_push_front(self, n);
+        }
+        if (out_value) {
+            *out_value = n->value;
+        }
+        return DCACHE_OK;
+    }
+}
+
+/* ---- Mutations ---------------------------------------------------------- */
+
+int dcache_put(dcache *self, const char *key, const char *value, uint64_t ttl_ms) {
+    if (!self || !key || !value) {
+        return DCACHE_ERR_OOM; /* treat as failure */
+    }
+    size_t klen = strlen(key);
+    size_t vlen = strlen(value);
+    if (self->max_bytes && (klen > self->max_bytes || vlen > self->max_bytes - klen)) {
+        return DCACHE_ERR_RANGE;
+    }
+    if (self->ttl_count) {
+        (void)dcache_sweep(self, DCACHE_SWEEP_STEP);
+    }
+    uint64_t expires = ttl_ms ? dcache_now_ms() + ttl_ms : 0;
+
+    dcache_node *n = dcache_find(self, key, klen);
+    char *nv = dcache_copy(value, vlen);
+    if (!nv) {
+        return DCACHE_ERR_OOM;
+    }
+    else if (n) {
+        free(n->value);
+        self->bytes = self->bytes - n->vlen + vlen;
+        self->ttl_count = self->ttl_count - (n->expires != 0) + (expires != 0);
+        n->value = nv;
+        n->vlen = vlen;
+        n->expires = expires;
+        if (self->policy == DCACHE_CLOCK) {
+            n->referenced = true;
+        }
+        else if (self->head != n) {
+            dcache_unlink(self, n);
+            dcache_push_front(self, n);
+        }
+    }
+    else {
+        n = (dcache_node*)malloc(sizeof(dcache_node) + klen + 1);
+        if (!n) {
+            free(nv);
+            return DCACHE_ERR_OOM;
+        }
+        memcpy(n->key, key, klen + 1);
+        n->klen = klen;
+        n->value = nv;
+        n->vlen = vlen;
+        n->expires = expires;
+        n->referenced = false;
+        if (dict_insert_n(self->map, key, klen, &n, sizeof(n)) != DICT_OK) {
+            free(nv);
+            free(n);
+            return DCACHE_ERR_OOM;
+        }
+        dcache_push_front(self, n);
+        self->count++;
+        self->bytes += klen + vlen;
+        if (expires) {
+            self->ttl_count++;
+        }
+    }
+
+    /* the new entry alone fits the budgets; older entries go first */
+    while (dcache_over_budget(self)) {
+        dcache_evict_one(self, n);
+    }
+    return DCACHE_OK;
+}
+
+int dcache_del(dcache *self, const char *key) {
+    if (!self || !key) {
+        return DCACHE_ERR_NOTFOUND;
+    }
+    dcache_node *n = dcache_find(self, key, strlen(key));
+    if (!n) {
+        return DCACHE_ERR_NOTFOUND;
+    }
+    else {
+        dcache_remove(self, n);
+        return DCACHE_OK;
+    }
+}
+
+size_t dcache_sweep(dcache *self, size_t max_visits) {
+    size_t removed = 0;
+    if (!self || !self->ttl_count) {
+        return 0;
+    }
+    uint64_t now = dcache_now_ms();
+    for (size_t v = 0; v < max_visits && self->tail; ++v) {
+        dcache_node *n = self->sweep ? self->sweep : self->tail;
+        self->sweep = n->prev; /* NULL past the head: wrap next time */
+        if (dcache_expired(n, now)) {
+            dcache_remove(self, n);
+            ++removed;
+        }
+    }
+    return removed;
+}
@@ -2,244 +2,839 @@
 
 #include <stdlib.h>
 #include <string.h>
-#include <stdio.h>   
+#include <stdio.h>
+#include <stdint.h>
+
+#include "ds_hash.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DICT_SSE2 1
+#include <emmintrin.h>
+#else
+#define DICT_SSE2 0
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 /* Configuration:
-   - Open addressing with double hashing.
-   - Base = next prime >= requested size.
-   - Resizes on load-factor thresholds (grow >70%, shrink <10%). */
+   - Flat open addressing in the style of a Swiss table: a slot array of
+     {hash, key length, key, value} plus one control byte per slot.
+   - A control byte is EMPTY, DELETED (tombstone) or, for a full slot, the
+     low 7 bits of the key's hash (H2). The remaining bits (H1) pick the
+     first probe group.
+   - Probing inspects 16 control bytes at a time (one SSE2 compare where
+     available) and walks groups in triangular order. Only slots whose H2
+     matches are examined, and those compare the cached full hash and
+     length before touching the key bytes.
+   - Capacity is a power of two (at least one group); resizes on
+     load-factor thresholds (grow >70%, shrink <10%, never below the size
+     requested from new_dict_with_capacity). All sizing is size_t, so tables
+     may exceed 2^32 slots where memory allows.
+   - Tombstones are counted. A delete whose group still has an EMPTY slot
+     writes EMPTY instead, because no probe chain continues past such a
+     group. When live + deleted slots exceed 85% the table is cleaned in
+     place (same size, no allocation) so churn cannot fill it with
+     tombstones.
+   - Entries live inline in the slot array. Key/value bytes come from malloc,
+     or for dictionaries made by dict_new_arena from a per-dictionary arena:
+     bump-allocated chunks with power-of-two size classes and per-class free
+     lists for reuse; dict_dispose then frees chunks, not entries.
+   - Optional incremental rehashing (Redis-style): a resize allocates the new
+     table and keeps the old one; every insert/delete then migrates a bounded
+     number of slots, and lookups consult both tables until the old one is
+     drained.
+   - Each key is hashed once per operation, by default with the 64-bit
+     wyhash-style mix from ds_hash.h (shared with cdict). Dictionaries made
+     by new_dict_with_hash(DICT_HASH_SIPHASH) use SipHash-1-3 under a random
+     per-instance key instead, so colliding keys cannot be precomputed.
+   - dict_get_many resolves keys in batches: hash all, prefetch home groups,
+     prefetch the first H2-matching slots, then probe, so the cache misses
+     of independent lookups overlap instead of running back to back.
+   - Keys and values are length-delimited byte strings (binary-safe); the
+     NUL-terminated API is a thin strlen wrapper. Stored copies still get a
+     trailing NUL so string users can read values directly. */
+
+typedef struct slot {
+    uint64_t hash;
+    size_t   klen;
+    size_t   vlen;
+    char    *key;    /* klen bytes + NUL */
+    char    *value;  /* vlen bytes + NUL */
+} slot;
 
-typedef struct item {
-    char *key;
-    char *value;
-} item;
+/* One open-addressing table. */
+typedef struct dict_table {
+    size_t   cap;    /* number of slots (power of two, multiple of DICT_GROUP) */
+    size_t   count;  /* live entries (excludes tombstones) */
+    size_t   deleted; /* tombstones (CTRL_DELETED slots) */
+    uint8_t *ctrl;   /* cap control bytes */
+    slot    *slots;  /* cap slots; only meaningful where ctrl is full */
+} dict_table;
+
+typedef struct dict_arena dict_arena;
 
 struct dictionary {
-    size_t base_size;   /* logical sizing knob (pre-prime) */
-    size_t size;        /* number of buckets (prime) */
-    size_t count;       /* number of stored entries (excludes deleted tombstones) */
-    item **items;       /* buckets: NULL / &deleted_sentinel / heap-allocated item */
+    dict_arena *arena;      /* string storage; NULL = malloc/free */
+    dict_table tab;         /* current table; receives all new entries */
+    dict_table old;         /* table being drained (cap == 0 when idle) */
+    size_t     min_cap;     /* shrinking never goes below this */
+    size_t     migrate_pos; /* next old slot to migrate */
+    bool       incremental; /* resize incrementally instead of all at once */
+    int        hash_mode;   /* DICT_HASH_* */
+    uint64_t   hash_key[2]; /* SipHash key (DICT_HASH_SIPHASH only) */
+#ifdef DS_STATS
+    size_t     resizes;     /* completed table reallocations */
+#endif
 };
 
 /* ---- internals: constants, helpers ------------------------------------- */
 
-static const unsigned PRIME_1 = 151u;
-static const unsigned PRIME_2 = 163u;
-static const size_t   DICT_INIT_BASE_SIZE = 50u;
+#define DICT_GROUP 16u
+#define DICT_NPOS  SIZE_MAX
+#define DICT_BATCH 16u      /* keys in flight per dict_get_many round */
 
-/* Tombstone sentinel for deleted buckets (address used, contents ignored). */
-static item DELETED_SENTINEL = { NULL, NULL };
+#if defined(__GNUC__) || defined(__clang__)
+#define DICT_PREFETCH(p) __builtin_prefetch((p), 0, 1)
+#else
+#define DICT_PREFETCH(p) ((void)(p))
+#endif
 
-/* strdup is not ISO C; provide a small replacement for portability. */
-static char *dupstr(const char *s) {
-    if (!s) {
-        return NULL;
+static const size_t  DICT_INIT_CAPACITY = 64u;
+static const size_t  DICT_REHASH_STEP   = 64u;   /* old slots migrated per operation */
+static const size_t  DICT_MAX_LOAD_PCT  = 70u;   /* live entries before growing */
+static const size_t  DICT_MIN_LOAD_PCT  = 10u;   /* live entries before shrinking */
+static const size_t  DICT_MAX_USED_PCT  = 85u;   /* live + tombstones before cleanup */
+static const uint8_t CTRL_EMPTY   = 0x80u;
+static const uint8_t CTRL_DELETED = 0xFEu;
+
+/* ---- internals: string storage ----------------------------------------- */
+
+/* Arena layout: strings are carved from DICT_ARENA_CHUNK-byte chunks in
+   size classes of 16 << c bytes. Freed blocks go on the free list of their
+   class (linked through their first word); requests above the largest
+   class get their own malloc block on a doubly linked list so they can be
+   freed individually. Callers always pass the string length back on free,
+   so blocks carry no per-string header. */
+#define DICT_ARENA_CLASSES 9u                       /* 16 .. 4096 bytes */
+#define DICT_ARENA_MAX     ((size_t)16u << (DICT_ARENA_CLASSES - 1u))
+#define DICT_ARENA_CHUNK   ((size_t)64u * 1024u)
+#define DICT_ARENA_HDR     16u                      /* keeps blocks 16-aligned */
+
+typedef struct arena_chunk {
+    struct arena_chunk *next;
+} arena_chunk;
+
+typedef struct arena_big {
+    struct arena_big *prev;
+    struct arena_big *next;
+} arena_big;
+
+struct dict_arena {
+    arena_chunk *chunks;
+    char        *bump;     /* next free byte in the newest chunk */
+    size_t       left;     /* bytes left after bump */
+    void        *free_list[DICT_ARENA_CLASSES];
+    arena_big   *big;
+};
+
+static unsigned arena_class(size_t n) {
+    unsigned c = 0;
+    size_t sz = 16u;
+    while (sz < n) {
+        sz <<= 1;
+        ++c;
     }
-    else {
-        size_t n = strlen(s) + 1;
-        char *p = (char*)malloc(n);
-        if (!p) {
+    return c;
+}
+
+static void *arena_alloc(dict_arena *a, size_t n) {
+    if (n > DICT_ARENA_MAX) {
+        arena_big *b = (arena_big*)malloc(DICT_ARENA_HDR + n);
+        if (!b) {
             return NULL;
         }
         else {
-            memcpy(p, s, n);
-            return p;
+            b->prev = NULL;
+            b->next = a->big;
+            if (a->big) {
+                a->big->prev = b;
+            }
+            a->big = b;
+            return (char*)b + DICT_ARENA_HDR;
         }
     }
+
+    unsigned c = arena_class(n);
+    size_t sz = (size_t)16u << c;
+    if (a->free_list[c]) {
+        void *p = a->free_list[c];
+        memcpy(&a->free_list[c], p, sizeof(void*));
+        return p;
+    }
+    else {
+        if (a->left < sz) {
+            arena_chunk *ch = (arena_chunk*)malloc(DICT_ARENA_HDR + DICT_ARENA_CHUNK);
+            if (!ch) {
+                return NULL;
+            }
+            ch->next = a->chunks;
+            a->chunks = ch;
+            a->bump = (char*)ch + DICT_ARENA_HDR;
+            a->left = DICT_ARENA_CHUNK;
+        }
+        void *p = a->bump;
+        a->bump += sz;
+        a->left -= sz;
+        return p;
+    }
 }
 
-/* Prime utilities (simple trial division; sufficient for these sizes). */
-static int is_prime(int x) {
-    if (x < 2) {
-        return 0;
+static void arena_free(dict_arena *a, void *p, size_t n) {
+    if (n > DICT_ARENA_MAX) {
+        arena_big *b = (arena_big*)((char*)p - DICT_ARENA_HDR);
+        if (b->prev) {
+            b->prev->next = b->next;
+        }
+        else {
+            a->big = b->next;
+        }
+        if (b->next) {
+            b->next->prev = b->prev;
+        }
+        free(b);
     }
-    else if (x == 2 || x == 3) {
-        return 1;
+    else {
+        unsigned c = arena_class(n);
+        memcpy(p, &a->free_list[c], sizeof(void*));
+        a->free_list[c] = p;
     }
-    else if ((x % 2) == 0) {
-        return 0;
+}
+
+static void arena_destroy(dict_arena *a) {
+    while (a->chunks) {
+        arena_chunk *next = a->chunks->next;
+        free(a->chunks);
+        a->chunks = next;
+    }
+    while (a->big) {
+        arena_big *next = a->big->next;
+        free(a->big);
+        a->big = next;
+    }
+    free(a);
+}
+
+/* Copies n bytes and appends a NUL so stored strings stay C strings. */
+static char *dict_str_new(dict *self, const void *src, size_t n) {
+    char *p = self->arena ? (char*)arena_alloc(self->arena, n + 1) : (char*)malloc(n + 1);
+    if (!p) {
+        return NULL;
     }
     else {
-        for (int i = 3; (long long)i * i <= x; i += 2) {
-            if ((x % i) == 0) {
-                return 0;
-            }
-            else {
-                /* keep testing */
-            }
-        }
-        return 1;
+        memcpy(p, src, n);
+        p[n] = '\0';
+        return p;
+    }
+}
+
+/* n is the string length as stored (without the NUL). */
+static void dict_str_free(dict *self, char *p, size_t n) {
+    if (!p) {
+        return;
+    }
+    else if (self->arena) {
+        arena_free(self->arena, p, n + 1);
     }
+    else {
+        free(p);
+    }
+}
+
+static void dict_slot_free(dict *self, slot *s) {
+    dict_str_free(self, s->key, s->klen);
+    dict_str_free(self, s->value, s->vlen);
 }
 
-static int next_prime(int x) {
-    if (x <= 2) {
-        return 2;
+/* True if a string of length old_n can be overwritten with new_n bytes
+   without reallocating: malloc blocks never grow in place, arena blocks may
+   change length within their size class (big blocks only shrink). */
+static bool dict_str_fits(const dict *self, size_t old_n, size_t new_n) {
+    if (!self->arena || old_n + 1 > DICT_ARENA_MAX) {
+        return new_n <= old_n && (!self->arena || new_n + 1 > DICT_ARENA_MAX);
     }
     else {
-        if ((x % 2) == 0) {
-            x += 1;
+        return new_n + 1 <= DICT_ARENA_MAX && arena_class(new_n + 1) == arena_class(old_n + 1);
+    }
+}
+
+/* Replaces s's value, reusing its storage when the new bytes fit. value may
+   point into the current value. */
+static int dict_set_value(dict *self, slot *s, const void *value, size_t vlen) {
+    if (dict_str_fits(self, s->vlen, vlen)) {
+        memmove(s->value, value, vlen);
+        s->value[vlen] = '\0';
+        s->vlen = vlen;
+        return DICT_OK;
+    }
+    else {
+        char *nv = dict_str_new(self, value, vlen);
+        if (!nv) {
+            return DICT_ERR_OOM;
         }
-        while (!is_prime(x)) {
-            x += 2;
+        else {
+            dict_str_free(self, s->value, s->vlen);
+            s->value = nv;
+            s->vlen = vlen;
+            return DICT_OK;
         }
-        return x;
     }
 }
 
-/* Polynomial rolling hash without pow(); computed left-to-right.
-   Uses modular arithmetic to keep values in-range. */
-static unsigned hash_poly(const char *s, unsigned a, unsigned m) {
-    unsigned long long h = 0ull;
-    for (const unsigned char *p = (const unsigned char*)s; *p; ++p) {
-        h = (h * a + (unsigned long long)(*p)) % m;
+static uint64_t dict_hash_key(const dict *self, const void *key, size_t klen) {
+    if (self->hash_mode == DICT_HASH_SIPHASH) {
+        return ds_siphash13(key, klen, self->hash_key[0], self->hash_key[1]);
+    }
+    else {
+        return ds_hash64(key, klen, 0);
     }
-    return (unsigned)h;
 }
 
-/* Double hash: h(k, i) = (h1(k) + i*(h2(k)+1)) mod m */
-static unsigned bucket_index(const char *s, unsigned m, unsigned attempt) {
-    unsigned h1 = hash_poly(s, PRIME_1, m);
-    unsigned h2 = hash_poly(s, PRIME_2, m);
-    return (h1 + attempt * (h2 + 1u)) % m;
+static uint8_t ctrl_h2(uint64_t h) {
+    return (uint8_t)(h & 0x7Fu);
 }
 
-/* Bucket item helpers */
-static item *item_new(const char *k, const char *v) {
-    item *it = (item*)malloc(sizeof(*it));
-    if (!it) {
-        return NULL;
+static size_t ctrl_h1(uint64_t h) {
+    return (size_t)(h >> 7);
+}
+
+static bool ctrl_is_full(uint8_t c) {
+    return (c & 0x80u) == 0;
+}
+
+/* ---- internals: control-byte groups ------------------------------------ */
+
+/* Bit i of a group mask refers to slot (group start + i). */
+typedef uint32_t group_mask;
+
+static unsigned mask_lowest(group_mask m) {
+#if defined(__GNUC__)
+    return (unsigned)__builtin_ctz(m);
+#elif defined(_MSC_VER)
+    unsigned long i;
+    _BitScanForward(&i, m);
+    return (unsigned)i;
+#else
+    unsigned i = 0;
+    while (!(m & 1u)) {
+        m >>= 1;
+        ++i;
+    }
+    return i;
+#endif
+}
+
+/* Slots in the group whose control byte equals b. */
+static group_mask group_match(const uint8_t *g, uint8_t b) {
+#if DICT_SSE2
+    __m128i ctrl = _mm_loadu_si128((const __m128i*)g);
+    return (group_mask)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)b)));
+#else
+    group_mask m = 0;
+    for (unsigned i = 0; i < DICT_GROUP; ++i) {
+        m |= (group_mask)(g[i] == b) << i;
+    }
+    return m;
+#endif
+}
+
+/* Slots that are EMPTY or DELETED: exactly the bytes with the top bit set. */
+static group_mask group_match_free(const uint8_t *g) {
+#if DICT_SSE2
+    return (group_mask)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)g));
+#else
+    group_mask m = 0;
+    for (unsigned i = 0; i < DICT_GROUP; ++i) {
+        m |= (group_mask)(g[i] >> 7) << i;
+    }
+    return m;
+#endif
+}
+
+/* Triangular probing over groups: visits every group once when the number
+   of groups is a power of two. */
+typedef struct probe {
+    size_t pos;     /* first slot of the current group */
+    size_t stride;
+} probe;
+
+static void probe_start(probe *p, uint64_t h, size_t cap) {
+    p->pos = ctrl_h1(h) & (cap - 1) & ~(size_t)(DICT_GROUP - 1);
+    p->stride = 0;
+}
+
+static void probe_next(probe *p, size_t cap) {
+    p->stride += DICT_GROUP;
+    p->pos = (p->pos + p->stride) & (cap - 1);
+}
+
+/* ---- internals: table operations --------------------------------------- */
+
+static int table_init(dict_table *t, size_t cap) {
+    t->cap = cap;
+    t->count = 0;
+    t->deleted = 0;
+    if (cap > SIZE_MAX / sizeof(slot)) {
+        t->ctrl = NULL;
+        t->slots = NULL;
+        return DICT_ERR_OOM;
+    }
+    t->ctrl = (uint8_t*)malloc(cap);
+    t->slots = (slot*)malloc(cap * sizeof(slot));
+    if (!t->ctrl || !t->slots) {
+        free(t->ctrl);
+        free(t->slots);
+        t->ctrl = NULL;
+        t->slots = NULL;
+        return DICT_ERR_OOM;
     }
     else {
-        it->key = dupstr(k);
-        it->value = dupstr(v ? v : "");
-        if (!it->key || !it->value) {
-            free(it->key);
-            free(it->value);
-            free(it);
-            return NULL;
+        memset(t->ctrl, CTRL_EMPTY, cap);
+        return DICT_OK;
+    }
+}
+
+/* Frees the arrays only; entries must have been released or moved. */
+static void table_release(dict_table *t) {
+    free(t->ctrl);
+    free(t->slots);
+    t->ctrl = NULL;
+    t->slots = NULL;
+    t->cap = 0;
+    t->count = 0;
+    t->deleted = 0;
+}
+
+/* Returns the slot index holding key, or DICT_NPOS. */
+static size_t table_find(const dict_table *t, const void *key, size_t klen, uint64_t h) {
+    uint8_t h2 = ctrl_h2(h);
+    size_t groups = t->cap / DICT_GROUP;
+    probe p;
+    probe_start(&p, h, t->cap);
+    for (size_t g = 0; g < groups; ++g) {
+        const uint8_t *ctrl = &t->ctrl[p.pos];
+        group_mask m = group_match(ctrl, h2);
+        while (m) {
+            size_t i = p.pos + mask_lowest(m);
+            const slot *s = &t->slots[i];
+            if (s->hash == h && s->klen == klen && memcmp(s->key, key, klen) == 0) {
+                return i;
+            }
+            m &= m - 1;
         }
-        else {
-            return it;
+        if (group_match(ctrl, CTRL_EMPTY)) {
+            return DICT_NPOS; /* an empty slot ends every chain through this group */
         }
+        probe_next(&p, t->cap);
     }
+    return DICT_NPOS;
 }
 
-static void item_free(item *it) {
-    if (!it || it == &DELETED_SENTINEL) {
-        return;
+/* table_find that also reports, through *out_free, the first EMPTY or
+   DELETED slot on the way (DICT_NPOS if none), i.e. where key would be
+   inserted. Lets upserts finish with a single probe. */
+static size_t table_find_slot(const dict_table *t, const void *key, size_t klen, uint64_t h,
+                              size_t *out_free) {
+    uint8_t h2 = ctrl_h2(h);
+    size_t groups = t->cap / DICT_GROUP;
+    probe p;
+    probe_start(&p, h, t->cap);
+    *out_free = DICT_NPOS;
+    for (size_t g = 0; g < groups; ++g) {
+        const uint8_t *ctrl = &t->ctrl[p.pos];
+        group_mask m = group_match(ctrl, h2);
+        while (m) {
+            size_t i = p.pos + mask_lowest(m);
+            const slot *s = &t->slots[i];
+            if (s->hash == h && s->klen == klen && memcmp(s->key, key, klen) == 0) {
+                return i;
+            }
+            m &= m - 1;
+        }
+        if (*out_free == DICT_NPOS) {
+            group_mask f = group_match_free(ctrl);
+            if (f) {
+                *out_free = p.pos + mask_lowest(f);
+            }
+        }
+        if (group_match(ctrl, CTRL_EMPTY)) {
+            return DICT_NPOS;
+        }
+        probe_next(&p, t->cap);
+    }
+    return DICT_NPOS;
+}
+
+/* Returns the first EMPTY or DELETED slot on h's probe sequence. */
+static size_t table_find_free(const dict_table *t, uint64_t h) {
+    size_t groups = t->cap / DICT_GROUP;
+    probe p;
+    probe_start(&p, h, t->cap);
+    for (size_t g = 0; g < groups; ++g) {
+        group_mask m = group_match_free(&t->ctrl[p.pos]);
+        if (m) {
+            return p.pos + mask_lowest(m);
+        }
+        probe_next(&p, t->cap);
+    }
+    return DICT_NPOS;
+}
+
+/* Fills a free slot found by table_find_free. */
+static void table_put(dict_table *t, size_t i, const slot *s) {
+    if (t->ctrl[i] == CTRL_DELETED) {
+        t->deleted--;
+    }
+    t->ctrl[i] = ctrl_h2(s->hash);
+    t->slots[i] = *s;
+    t->count++;
+}
+
+/* Marks slot i free after its entry was released or moved out. */
+static void table_erase(dict_table *t, size_t i) {
+    if (group_match(&t->ctrl[i & ~(size_t)(DICT_GROUP - 1)], CTRL_EMPTY)) {
+        t->ctrl[i] = CTRL_EMPTY;
     }
     else {
-        free(it->key);
-        free(it->value);
-        free(it);
-        return;
+        t->ctrl[i] = CTRL_DELETED;
+        t->deleted++;
+    }
+    t->count--;
+}
+
+/* Removes every tombstone without allocating: each live entry is re-placed
+   at the first free slot of its own probe sequence. Entries already in that
+   group stay put; others move to an EMPTY target or swap with a
+   not-yet-placed entry, which is then processed in turn. */
+static void table_drop_deletes(dict_table *t) {
+    /* full -> DELETED ("still to place"), tombstone -> EMPTY */
+    for (size_t i = 0; i < t->cap; ++i) {
+        t->ctrl[i] = ctrl_is_full(t->ctrl[i]) ? CTRL_DELETED : CTRL_EMPTY;
+    }
+
+    size_t group_bits = ~(size_t)(DICT_GROUP - 1);
+    size_t i = 0;
+    while (i < t->cap) {
+        if (t->ctrl[i] != CTRL_DELETED) {
+            ++i;
+            continue;
+        }
+
+        uint64_t h = t->slots[i].hash;
+        size_t target = table_find_free(t, h);
+        if ((target & group_bits) == (i & group_bits)) {
+            t->ctrl[i] = ctrl_h2(h);      /* already in its first free group */
+            ++i;
+        }
+        else if (t->ctrl[target] == CTRL_EMPTY) {
+            t->slots[target] = t->slots[i];
+            t->ctrl[target] = ctrl_h2(h);
+            t->ctrl[i] = CTRL_EMPTY;
+            ++i;
+        }
+        else {
+            /* target holds an unplaced entry: swap and revisit slot i */
+            slot tmp = t->slots[target];
+            t->slots[target] = t->slots[i];
+            t->slots[i] = tmp;
+            t->ctrl[target] = ctrl_h2(h);
+        }
     }
+    t->deleted = 0;
 }
 
 /* ---- core dictionary routines ------------------------------------------ */
 
-static dict *dict_new_sized(size_t base_size) {
-    dict *d = (dict*)malloc(sizeof(*d));
-    if (!d) {
-        return NULL;
+static bool dict_rehashing(const dict *self) {
+    return self->old.cap != 0;
+}
+
+/* Moves up to max_slots old slots into the current table; releases the old
+   table once it is drained. Entries move by value with their cached hash. */
+static void dict_migrate(dict *self, size_t max_slots) {
+    dict_table *ot = &self->old;
+    size_t end = self->migrate_pos + max_slots;
+    if (end > ot->cap || end < self->migrate_pos) {
+        end = ot->cap;
     }
-    else {
-        d->base_size = base_size;
-        d->size  = (size_t)next_prime((int)base_size);
-        d->count = 0;
-        d->items = (item**)calloc(d->size, sizeof(item*));
-        if (!d->items) {
-            free(d);
-            return NULL;
+    for (size_t i = self->migrate_pos; i < end; ++i) {
+        if (ctrl_is_full(ot->ctrl[i])) {
+            table_put(&self->tab, table_find_free(&self->tab, ot->slots[i].hash), &ot->slots[i]);
+            table_erase(ot, i);
         }
         else {
-            return d;
+            /* skip empty or deleted */
         }
     }
+    self->migrate_pos = end;
+    if (self->migrate_pos == ot->cap) {
+        table_release(ot);
+        self->migrate_pos = 0;
+    }
 }
 
-/* Inserts into a specific table without triggering resize; used by rehash. */
-static int dict_insert_raw(dict *self, item *it) {
-    unsigned attempt = 0;
-    unsigned m = (unsigned)self->size;
-    unsigned idx = bucket_index(it->key, m, attempt);
+static void dict_migrate_all(dict *self) {
+    if (dict_rehashing(self)) {
+        dict_migrate(self, SIZE_MAX);
+    }
+}
 
-    while (self->items[idx] && self->items[idx] != &DELETED_SENTINEL) {
-        if (strcmp(self->items[idx]->key, it->key) == 0) {
-            /* Replace in-place (free old, keep slot) */
-            item_free(self->items[idx]);
-            self->items[idx] = it;
-            return DICT_OK;
+/* pct percent of cap, rounded down, without forming cap * pct (which could
+   overflow for tables past SIZE_MAX / 100 slots). */
+static size_t dict_pct(size_t cap, size_t pct) {
+    return cap / 100u * pct + cap % 100u * pct / 100u;
+}
+
+/* Smallest power-of-two capacity (>= DICT_INIT_CAPACITY) that holds n live
+   entries without crossing the grow threshold; 0 if that would overflow. */
+static size_t dict_capacity_for(size_t n) {
+    size_t cap = DICT_INIT_CAPACITY;
+    while (dict_pct(cap, DICT_MAX_LOAD_PCT) < n) {
+        if (cap > SIZE_MAX / 2u / sizeof(slot)) {
+            return 0;
+        }
+        else {
+            cap <<= 1;
         }
-        attempt++;
-        idx = bucket_index(it->key, m, attempt);
     }
+    return cap;
+}
 
-    self->items[idx] = it;
-    self->count++;
-    return DICT_OK;
+/* Switches to a fresh table of new_cap slots (which may equal the current
+   size: that drops tombstones). Immediate mode migrates every entry now;
+   incremental mode parks the current table in `old` and lets later
+   operations drain it. Cached hashes are reused, so no key is read again. */
+static int dict_rehash_into(dict *self, size_t new_cap) {
+    dict_table nt;
+    if (table_init(&nt, new_cap) != DICT_OK) {
+        return DICT_ERR_OOM;
+    }
+    else {
+        dict_migrate_all(self); /* at most one resize in flight */
+#ifdef DS_STATS
+        self->resizes++;
+#endif
+        self->old = self->tab;
+        self->tab = nt;
+        self->migrate_pos = 0;
+        if (!self->incremental) {
+            dict_migrate_all(self);
+        }
+        return DICT_OK;
+    }
 }
 
-/* Rehashes into a new table size; preserves entries. */
-static int dict_resize(dict *self, size_t new_base_size) {
-    if (new_base_size < DICT_INIT_BASE_SIZE) {
+static int dict_resize(dict *self, size_t new_cap) {
+    if (new_cap < self->min_cap || new_cap == self->tab.cap) {
         return DICT_OK; /* ignore */
     }
     else {
-        dict *nd = dict_new_sized(new_base_size);
-        if (!nd) {
-            return DICT_ERR_OOM;
+        return dict_rehash_into(self, new_cap);
+    }
+}
+
+/* Grow/shrink helpers based on load factor (%), measured against the
+   current table over all live entries. */
+static int dict_resize_up(dict *self) {
+    if (self->tab.cap > SIZE_MAX / 2u / sizeof(slot)) {
+        return DICT_ERR_OOM;
+    }
+    else {
+        return dict_resize(self, self->tab.cap * 2u);
+    }
+}
+
+static int dict_resize_down(dict *self) {
+    return dict_resize(self, self->tab.cap / 2u);
+}
+
+/* Makes room for one more entry: grows on live load, otherwise cleans out
+   tombstones once they push the current table past DICT_MAX_USED_PCT.
+   Immediate mode cleans in place (O(cap) now). Incremental mode rehashes
+   into a fresh table of the same size that later operations drain, so no
+   single insert pays for the whole table; while a rehash is already in
+   flight the cleanup waits for it (each operation drains DICT_REHASH_STEP
+   slots, far fewer than the 15% of the table still free). */
+static int dict_reserve_one(dict *self) {
+    if (dict_size(self) > dict_pct(self->tab.cap, DICT_MAX_LOAD_PCT)) {
+        return dict_resize_up(self);
+    }
+    else if (self->tab.count + self->tab.deleted > dict_pct(self->tab.cap, DICT_MAX_USED_PCT)) {
+        if (!self->incremental) {
+            dict_migrate_all(self);
+            table_drop_deletes(&self->tab);
+            return DICT_OK;
+        }
+        else if (dict_rehashing(self)) {
+            return DICT_OK;
+        }
+        else if (dict_rehash_into(self, self->tab.cap) != DICT_OK) {
+            table_drop_deletes(&self->tab); /* no memory for a fresh table */
+            return DICT_OK;
         }
         else {
-            for (size_t i = 0; i < self->size; ++i) {
-                item *it = self->items[i];
-                if (it && it != &DELETED_SENTINEL) {
-                    /* transfer ownership of `it` into new table */
-                    (void)dict_insert_raw(nd, it);
-                }
-                else {
-                    /* skip empty or deleted */
-                }
-            }
+            return DICT_OK;
+        }
+    }
+    else {
+        return DICT_OK;
+    }
+}
 
-            /* swap into place */
-            size_t tmp_sz = self->size;
-            self->size = nd->size;
-            nd->size = tmp_sz;
+/* Finds key in the current table, then in the table being drained.
+   Returns the owning table (and slot index via *out_i), or NULL. */
+static dict_table *dict_locate(const dict *self, const void *key, size_t klen, uint64_t h,
+                               size_t *out_i) {
+    size_t i = table_find(&self->tab, key, klen, h);
+    if (i != DICT_NPOS) {
+        *out_i = i;
+        return (dict_table*)&self->tab;
+    }
+    else if (dict_rehashing(self)) {
+        i = table_find(&self->old, key, klen, h);
+        if (i != DICT_NPOS) {
+            *out_i = i;
+            return (dict_table*)&self->old;
+        }
+    }
+    return NULL;
+}
 
-            size_t tmp_base = self->base_size;
-            self->base_size = nd->base_size;
-            nd->base_size = tmp_base;
+/* Upsert lookup: like dict_locate, but on a miss stores in *out_free the
+   slot of the current table where the key belongs. Callers run
+   dict_reserve_one first, so a free slot always exists. */
+static dict_table *dict_probe(const dict *self, const void *key, size_t klen, uint64_t h,
+                              size_t *out_i, size_t *out_free) {
+    size_t i = table_find_slot(&self->tab, key, klen, h, out_free);
+    if (i != DICT_NPOS) {
+        *out_i = i;
+        return (dict_table*)&self->tab;
+    }
+    else if (dict_rehashing(self)) {
+        i = table_find(&self->old, key, klen, h);
+        if (i != DICT_NPOS) {
+            *out_i = i;
+            return (dict_table*)&self->old;
+        }
+    }
+    if (*out_free == DICT_NPOS) {
+        *out_free = table_find_free(&self->tab, h); /* chain spans every group */
+    }
+    return NULL;
+}
 
-            item **tmp_items = self->items;
-            self->items = nd->items;
-            nd->items = tmp_items;
+/* Copies key and value into a new entry at free slot i of the current table. */
+static slot *dict_put_new(dict *self, size_t i, uint64_t h, const void *key, size_t klen,
+                          const void *value, size_t vlen) {
+    slot s;
+    s.hash = h;
+    s.klen = klen;
+    s.vlen = vlen;
+    s.key = dict_str_new(self, key, klen);
+    s.value = dict_str_new(self, value, vlen);
+    if (!s.key || !s.value) {
+        dict_slot_free(self, &s);
+        return NULL;
+    }
+    else {
+        table_put(&self->tab, i, &s);
+        return &self->tab.slots[i];
+    }
+}
 
-            /* nd now holds old arrays; dispose it (frees old buckets only) */
-            nd->count = 0; /* avoid double-free of moved items */
-            free(nd->items);
-            free(nd);
-            return DICT_OK;
-        }
+/* Frees slot i of t (its strings already released or handed out), then
+   shrinks if the load factor fell below 10%. */
+static void dict_remove_at(dict *self, dict_table *t, size_t i) {
+    table_erase(t, i);              /* EMPTY or tombstone */
+    if (dict_size(self) < dict_pct(self->tab.cap, DICT_MIN_LOAD_PCT)) {
+        (void)dict_resize_down(self);   /* ignore OOM on shrink */
     }
 }
 
-/* Grow/shrink helpers based on load factor (%). */
-static int dict_resize_up(dict *self) {
-    return dict_resize(self, self->base_size * 2u);
+/* Common prologue of every mutation: advance a pending incremental rehash,
+   then grow if load factor exceeds 70% or purge tombstones past 85% used. */
+static int dict_prepare_write(dict *self) {
+    if (dict_rehashing(self)) {
+        dict_migrate(self, DICT_REHASH_STEP);
+    }
+    return dict_reserve_one(self);
 }
 
-static int dict_resize_down(dict *self) {
-    return dict_resize(self, (self->base_size > DICT_INIT_BASE_SIZE)
-                              ? (self->base_size / 2u)
-                              : self->base_size);
+/* Releases a table and, unless the arena will drop them wholesale, its strings. */
+static void table_dispose_entries(dict *self, dict_table *t) {
+    if (!self->arena) {
+        for (size_t i = 0; i < t->cap; ++i) {
+            if (ctrl_is_full(t->ctrl[i])) {
+                dict_slot_free(self, &t->slots[i]);
+            }
+        }
+    }
+    table_release(t);
 }
 
 /* ---- public API --------------------------------------------------------- */
 
 dict *new_dict(void) {
-    return dict_new_sized(DICT_INIT_BASE_SIZE);
+    return new_dict_with_capacity(0);
+}
+
+dict *new_dict_with_capacity(size_t n) {
+    size_t cap = dict_capacity_for(n);
+    dict *d = cap ? (dict*)calloc(1, sizeof(*d)) : NULL;
+    if (!d) {
+        return NULL;
+    }
+    else if (table_init(&d->tab, cap) != DICT_OK) {
+        free(d);
+        return NULL;
+    }
+    else {
+        /* old table idle, incremental mode off, no arena (calloc) */
+        d->min_cap = cap;
+        return d;
+    }
+}
+
+dict *new_dict_with_hash(int mode) {
+    if (mode != DICT_HASH_FAST && mode != DICT_HASH_SIPHASH) {
+        return NULL;
+    }
+    dict *d = new_dict();
+    if (d) {
+        d->hash_mode = mode;
+        if (mode == DICT_HASH_SIPHASH) {
+            ds_hash_random_key(d->hash_key);
+        }
+    }
+    return d;
+}
+
+dict *dict_new_arena(void) {
+    dict *d = new_dict();
+    if (!d) {
+        return NULL;
+    }
+    else {
+        d->arena = (dict_arena*)calloc(1, sizeof(dict_arena));
+        if (!d->arena) {
+            dict_dispose(d);
+            return NULL;
+        }
+        else {
+            return d;
+        }
+    }
 }
 
 void dict_dispose(dict *self) {
@@ -247,144 +842,574 @@ void dict_dispose(dict *self) {
         return;
     }
     else {
-        for (size_t i = 0; i < self->size; ++i) {
-            item_free(self->items[i]);
+        table_dispose_entries(self, &self->tab);
+        if (dict_rehashing(self)) {
+            table_dispose_entries(self, &self->old);
+        }
+        if (self->arena) {
+            arena_destroy(self->arena);
         }
-        free(self->items);
         free(self);
         return;
     }
 }
 
+void dict_set_incremental_rehash(dict *self, bool enable) {
+    if (!self) {
+        return;
+    }
+    else {
+        self->incremental = enable;
+        if (!enable) {
+            dict_migrate_all(self);
+        }
+        return;
+    }
+}
+
+bool dict_is_rehashing(const dict *self) {
+    return self && dict_rehashing(self);
+}
+
+int dict_compact(dict *self) {
+    if (!self) {
+        return DICT_ERR_NOTFOUND;
+    }
+    else {
+        dict_migrate_all(self);
+        if (self->tab.deleted > 0) {
+            table_drop_deletes(&self->tab);
+        }
+        return DICT_OK;
+    }
+}
+
 size_t dict_size(const dict *self) {
     if (!self) {
         return 0;
     }
     else {
-        return self->count;
+        return self->tab.count + self->old.count;
     }
 }
 
+bool dict_next(const dict *self, size_t *cursor, const char **out_key, size_t *out_klen,
+               const char **out_value, size_t *out_vlen) {
+    if (!self || !cursor) {
+        return false;
+    }
+    else {
+        /* cursor walks the current table's slots, then the old table's */
+        size_t total = self->tab.cap + self->old.cap;
+        for (size_t c = *cursor; c < total; ++c) {
+            const dict_table *t = c < self->tab.cap ? &self->tab : &self->old;
+            size_t i = c < self->tab.cap ? c : c - self->tab.cap;
+            if (ctrl_is_full(t->ctrl[i])) {
+                const slot *s = &t->slots[i];
+                if (out_key) {
+                    *out_key = s->key;
+                }
+                if (out_klen) {
+                    *out_klen = s->klen;
+                }
+                if (out_value) {
+                    *out_value = s->value;
+                }
+                if (out_vlen) {
+                    *out_vlen = s->vlen;
+                }
+                *cursor = c + 1;
+                return true;
+            }
+        }
+        *cursor = total;
+        return false;
+    }
+}
+
+uint64_t dict_hash(const dict *self, const void *key, size_t klen) {
+    return (self && key) ? dict_hash_key(self, key, klen) : 0;
+}
+
 bool dict_contains(const dict *self, const char *key) {
     const char *dummy = NULL;
     return dict_get(self, key, &dummy) == DICT_OK;
 }
 
 int dict_get(const dict *self, const char *key, const char **out_value) {
+    if (!key) {
+        return DICT_ERR_NOTFOUND;
+    }
+    else {
+        return dict_get_n(self, key, strlen(key), out_value, NULL);
+    }
+}
+
+int dict_get_n(const dict *self, const void *key, size_t klen,
+               const char **out_value, size_t *out_vlen) {
     if (!self || !key) {
         return DICT_ERR_NOTFOUND;
     }
     else {
-        unsigned attempt = 0;
-        unsigned m = (unsigned)self->size;
-        unsigned idx = bucket_index(key, m, attempt);
+        return dict_get_hashed(self, key, klen, dict_hash_key(self, key, klen),
+                               out_value, out_vlen);
+    }
+}
 
-        item *it = self->items[idx];
-        while (it) {
-            if (it != &DELETED_SENTINEL) {
-                if (strcmp(it->key, key) == 0) {
-                    if (out_value) {
-                        *out_value = it->value; /* owned by dict */
-                    }
-                    return DICT_OK;
+int dict_get_hashed(const dict *self, const void *key, size_t klen, uint64_t h,
+                    const char **out_value, size_t *out_vlen) {
+    if (!self || !key) {
+        return DICT_ERR_NOTFOUND;
+    }
+    else {
+        size_t i;
+        dict_table *t = dict_locate(self, key, klen, h, &i);
+        if (!t) {
+            return DICT_ERR_NOTFOUND;
+        }
+        else {
+            if (out_value) {
+                *out_value = t->slots[i].value; /* owned by dict */
+            }
+            if (out_vlen) {
+                *out_vlen = t->slots[i].vlen;
+            }
+            return DICT_OK;
+        }
+    }
+}
+
+/* Pulls in the home group's control bytes for h in every live table. */
+static void dict_prefetch_ctrl(const dict *self, uint64_t h) {
+    probe p;
+    probe_start(&p, h, self->tab.cap);
+    DICT_PREFETCH(&self->tab.ctrl[p.pos]);
+    if (dict_rehashing(self)) {
+        probe_start(&p, h, self->old.cap);
+        DICT_PREFETCH(&self->old.ctrl[p.pos]);
+    }
+}
+
+/* Prefetches the first slot in h's home group whose H2 matches (reading the
+   control bytes requested by dict_prefetch_ctrl). */
+static void dict_prefetch_slot(const dict *self, uint64_t h) {
+    probe p;
+    probe_start(&p, h, self->tab.cap);
+    group_mask m = group_match(&self->tab.ctrl[p.pos], ctrl_h2(h));
+    if (m) {
+        DICT_PREFETCH(&self->tab.slots[p.pos + mask_lowest(m)]);
+    }
+}
+
+size_t dict_get_many(const dict *self, const char *const *keys, size_t n,
+                     const char **out_values, bool *out_found) {
+    size_t found = 0;
+    if (!self || !keys) {
+        return 0;
+    }
+    else {
+        uint64_t hash[DICT_BATCH];
+        size_t   klen[DICT_BATCH];
+        for (size_t base = 0; base < n; base += DICT_BATCH) {
+            size_t m = n - base < DICT_BATCH ? n - base : DICT_BATCH;
+            /* stage 1: hash every key and start loading its home group */
+            for (size_t j = 0; j < m; ++j) {
+                const char *k = keys[base + j];
+                klen[j] = k ? strlen(k) : 0;
+                hash[j] = k ? dict_hash_key(self, k, klen[j]) : 0;
+                dict_prefetch_ctrl(self, hash[j]);
+            }
+            /* stage 2: the groups are (mostly) cached; start loading slots */
+            for (size_t j = 0; j < m; ++j) {
+                dict_prefetch_slot(self, hash[j]);
+            }
+            /* stage 3: resolve the probes */
+            for (size_t j = 0; j < m; ++j) {
+                const char *k = keys[base + j];
+                size_t i;
+                dict_table *t = k ? dict_locate(self, k, klen[j], hash[j], &i) : NULL;
+                if (out_values) {
+                    out_values[base + j] = t ? t->slots[i].value : NULL;
                 }
-                else {
-                    /* continue probing */
+                if (out_found) {
+                    out_found[base + j] = t != NULL;
+                }
+                if (t) {
+                    ++found;
                 }
             }
-            attempt++;
-            idx = bucket_index(key, m, attempt);
-            it = self->items[idx];
         }
-        return DICT_ERR_NOTFOUND;
+        return found;
     }
 }
 
 int dict_insert(dict *self, const char *key, const char *value) {
+    if (!key || !value) {
+        return DICT_ERR_OOM; /* treat as failure */
+    }
+    else {
+        return dict_insert_n(self, key, strlen(key), value, strlen(value));
+    }
+}
+
+int dict_insert_n(dict *self, const void *key, size_t klen, const void *value, size_t vlen) {
     if (!self || !key || !value) {
         return DICT_ERR_OOM; /* treat as failure */
     }
     else {
-        /* grow if load factor exceeds 70% */
-        if (self->size == 0) {
+        return dict_insert_hashed(self, key, klen, dict_hash_key(self, key, klen), value, vlen);
+    }
+}
+
+int dict_insert_hashed(dict *self, const void *key, size_t klen, uint64_t h,
+                       const void *value, size_t vlen) {
+    if (!self || !key || !value) {
+        return DICT_ERR_OOM; /* treat as failure */
+    }
+    else {
+        int rc = dict_prepare_write(self);
+        if (rc != DICT_OK) {
+            return rc;
+        }
+
+        size_t i;
+        size_t free_i;
+        dict_table *t = dict_probe(self, key, klen, h, &i, &free_i);
+        if (t) {
+            /* replace the value only; the key and slot stay */
+            return dict_set_value(self, &t->slots[i], value, vlen);
+        }
+        else {
+            return dict_put_new(self, free_i, h, key, klen, value, vlen) ? DICT_OK : DICT_ERR_OOM;
+        }
+    }
+}
+
+int dict_get_or_insert(dict *self, const char *key, const char *default_value,
+                       char **out_value, bool *out_inserted) {
+    if (!self || !key || !default_value) {
+        return DICT_ERR_OOM; /* treat as failure */
+    }
+    else {
+        int rc = dict_prepare_write(self);
+        if (rc != DICT_OK) {
+            return rc;
+        }
+
+        size_t klen = strlen(key);
+        uint64_t h = dict_hash_key(self, key, klen);
+        size_t i;
+        size_t free_i;
+        dict_table *t = dict_probe(self, key, klen, h, &i, &free_i);
+        slot *s = t ? &t->slots[i] : dict_put_new(self, free_i, h, key, klen,
+                                                  default_value, strlen(default_value));
+        if (!s) {
             return DICT_ERR_OOM;
         }
         else {
-            size_t load = self->count * 100u / self->size;
-            if (load > 70u) {
-                int rc = dict_resize_up(self);
-                if (rc != DICT_OK) {
-                    return rc;
-                }
+            if (out_value) {
+                *out_value = s->value;
+            }
+            if (out_inserted) {
+                *out_inserted = (t == NULL);
             }
+            return DICT_OK;
         }
+    }
+}
 
-        item *it = item_new(key, value);
-        if (!it) {
-            return DICT_ERR_OOM;
+int dict_update(dict *self, const char *key, dict_update_fn fn, void *ctx) {
+    if (!self || !key || !fn) {
+        return DICT_ERR_OOM; /* treat as failure */
+    }
+    else {
+        int rc = dict_prepare_write(self);
+        if (rc != DICT_OK) {
+            return rc;
+        }
+
+        size_t klen = strlen(key);
+        uint64_t h = dict_hash_key(self, key, klen);
+        size_t i;
+        size_t free_i;
+        dict_table *t = dict_probe(self, key, klen, h, &i, &free_i);
+        size_t vlen = t ? t->slots[i].vlen : 0;
+        const char *nv = fn(key, t ? t->slots[i].value : NULL, &vlen, ctx);
+        if (!nv) {
+            return DICT_OK; /* callback chose to leave the entry as is */
+        }
+        else if (t) {
+            return dict_set_value(self, &t->slots[i], nv, vlen);
         }
         else {
-            int rc = dict_insert_raw(self, it);
-            return rc; /* DICT_OK or OOM (unlikely here since table already allocated) */
+            return dict_put_new(self, free_i, h, key, klen, nv, vlen) ? DICT_OK : DICT_ERR_OOM;
         }
     }
 }
 
 int dict_del(dict *self, const char *key) {
-    if (!self || !key || self->size == 0) {
+    if (!key) {
         return DICT_ERR_NOTFOUND;
     }
     else {
-        unsigned attempt = 0;
-        unsigned m = (unsigned)self->size;
-        unsigned idx = bucket_index(key, m, attempt);
-
-        item *it = self->items[idx];
-        while (it) {
-            if (it != &DELETED_SENTINEL) {
-                if (strcmp(it->key, key) == 0) {
-                    item_free(it);                      /* free key/value + item */
-                    self->items[idx] = &DELETED_SENTINEL; /* leave tombstone */
-                    if (self->count > 0) {
-                        self->count -= 1;
-                    }
-                    /* shrink if load factor falls below 10% */
-                    size_t load = self->count * 100u / self->size;
-                    if (load < 10u) {
-                        (void)dict_resize_down(self);   /* ignore OOM on shrink */
-                    }
-                    return DICT_OK;
-                }
-                else {
-                    /* continue probing */
-                }
+        return dict_del_n(self, key, strlen(key));
+    }
+}
+
+int dict_del_n(dict *self, const void *key, size_t klen) {
+    if (!self || !key) {
+        return DICT_ERR_NOTFOUND;
+    }
+    else {
+        return dict_del_hashed(self, key, klen, dict_hash_key(self, key, klen));
+    }
+}
+
+int dict_del_hashed(dict *self, const void *key, size_t klen, uint64_t h) {
+    if (!self || !key) {
+        return DICT_ERR_NOTFOUND;
+    }
+    else {
+        if (dict_rehashing(self)) {
+            dict_migrate(self, DICT_REHASH_STEP);
+        }
+
+        size_t i;
+        dict_table *t = dict_locate(self, key, klen, h, &i);
+        if (!t) {
+            return DICT_ERR_NOTFOUND;
+        }
+        else {
+            dict_slot_free(self, &t->slots[i]); /* free key/value */
+            dict_remove_at(self, t, i);
+            return DICT_OK;
+        }
+    }
+}
+
+int dict_insert_owned(dict *self, char *key, char *value) {
+    if (!self || !key || !value) {
+        return DICT_ERR_OOM; /* treat as failure */
+    }
+    else if (self->arena) {
+        /* arena strings must live in the arena: copy, then release ours */
+        int rc = dict_insert(self, key, value);
+        if (rc == DICT_OK) {
+            free(key);
+            free(value);
+        }
+        return rc;
+    }
+    else {
+        int rc = dict_prepare_write(self);
+        if (rc != DICT_OK) {
+            return rc;
+        }
+
+        size_t klen = strlen(key);
+        size_t vlen = strlen(value);
+        uint64_t h = dict_hash_key(self, key, klen);
+        size_t i;
+        size_t free_i;
+        dict_table *t = dict_probe(self, key, klen, h, &i, &free_i);
+        if (t) {
+            /* keep the stored key; adopt the new value */
+            dict_str_free(self, t->slots[i].value, t->slots[i].vlen);
+            t->slots[i].value = value;
+            t->slots[i].vlen = vlen;
+            free(key);
+        }
+        else {
+            slot s;
+            s.hash = h;
+            s.klen = klen;
+            s.vlen = vlen;
+            s.key = key;
+            s.value = value;
+            table_put(&self->tab, free_i, &s);
+        }
+        return DICT_OK;
+    }
+}
+
+int dict_take(dict *self, const char *key, char **out_key, char **out_value) {
+    if (!self || !key) {
+        return DICT_ERR_NOTFOUND;
+    }
+    else {
+        if (dict_rehashing(self)) {
+            dict_migrate(self, DICT_REHASH_STEP);
+        }
+
+        size_t klen = strlen(key);
+        size_t i;
+        dict_table *t = dict_locate(self, key, klen, dict_hash_key(self, key, klen), &i);
+        if (!t) {
+            return DICT_ERR_NOTFOUND;
+        }
+        slot *s = &t->slots[i];
+        char *k = NULL;
+        char *v = NULL;
+        if (self->arena) {
+            /* hand out malloc copies; both must succeed before the entry
+               is touched */
+            k = out_key ? (char*)malloc(s->klen + 1) : NULL;
+            v = out_value ? (char*)malloc(s->vlen + 1) : NULL;
+            if ((out_key && !k) || (out_value && !v)) {
+                free(k);
+                free(v);
+                return DICT_ERR_OOM; /* entry left in place */
+            }
+            if (k) {
+                memcpy(k, s->key, s->klen + 1);
+            }
+            if (v) {
+                memcpy(v, s->value, s->vlen + 1);
+            }
+            dict_slot_free(self, s);
+        }
+        else {
+            k = s->key;
+            v = s->value;
+            if (!out_key) {
+                free(k);
+                k = NULL;
+            }
+            if (!out_value) {
+                free(v);
+                v = NULL;
+            }
+        }
+        if (out_key) {
+            *out_key = k;
+        }
+        if (out_value) {
+            *out_value = v;
+        }
+        dict_remove_at(self, t, i);
+        return DICT_OK;
+    }
+}
+
+/* ---- Statistics ------------------------------------------------------- */
+
+/* Groups visited (1 = home group) before reaching the group holding slot i. */
+static size_t table_probe_len(const dict_table *t, size_t i) {
+    size_t target = i & ~(size_t)(DICT_GROUP - 1);
+    size_t groups = t->cap / DICT_GROUP;
+    probe p;
+    probe_start(&p, t->slots[i].hash, t->cap);
+    size_t n = 1;
+    while (p.pos != target && n < groups) {
+        probe_next(&p, t->cap);
+        ++n;
+    }
+    return n;
+}
+
+/* Mean groups an unsuccessful lookup visits, averaged over home groups
+   (uniform hashing makes every home group equally likely). */
+static double table_miss_probe_avg(const dict_table *t) {
+    size_t groups = t->cap / DICT_GROUP;
+    size_t total = 0;
+    for (size_t g = 0; g < groups; ++g) {
+        probe p;
+        p.pos = g * DICT_GROUP;
+        p.stride = 0;
+        size_t n = 1;
+        while (!group_match(&t->ctrl[p.pos], CTRL_EMPTY) && n < groups) {
+            probe_next(&p, t->cap);
+            ++n;
+        }
+        total += n;
+    }
+    return groups ? (double)total / (double)groups : 0.0;
+}
+
+static void table_stats(const dict *self, const dict_table *t, struct dict_stats *st, size_t *probe_sum) {
+    st->capacity += t->cap;
+    st->live += t->count;
+    st->tombstones += t->deleted;
+    st->bucket_bytes += t->cap;                  /* control bytes */
+    st->item_bytes += t->cap * sizeof(slot);
+    for (size_t i = 0; i < t->cap; ++i) {
+        if (ctrl_is_full(t->ctrl[i])) {
+            const slot *s = &t->slots[i];
+            size_t n = table_probe_len(t, i);
+            st->probe_hist[n < DICT_STATS_HIST ? n - 1 : DICT_STATS_HIST - 1]++;
+            if (n > st->max_probe) {
+                st->max_probe = n;
+            }
+            *probe_sum += n;
+            st->string_bytes += s->klen + s->vlen + 2u;
+            if (self->arena && s->klen + 1 > DICT_ARENA_MAX) {
+                st->arena_bytes += DICT_ARENA_HDR + s->klen + 1;
+            }
+            if (self->arena && s->vlen + 1 > DICT_ARENA_MAX) {
+                st->arena_bytes += DICT_ARENA_HDR + s->vlen + 1;
             }
-            attempt++;
-            idx = bucket_index(key, m, attempt);
-            it = self->items[idx];
         }
+    }
+}
+
+int dict_stats(const dict *self, struct dict_stats *out) {
+    if (!self || !out) {
         return DICT_ERR_NOTFOUND;
     }
+    else {
+        size_t probe_sum = 0;
+        memset(out, 0, sizeof(*out));
+        table_stats(self, &self->tab, out, &probe_sum);
+        out->avg_miss_probe = table_miss_probe_avg(&self->tab);
+        if (dict_rehashing(self)) {
+            /* a miss searches both tables */
+            table_stats(self, &self->old, out, &probe_sum);
+            out->avg_miss_probe += table_miss_probe_avg(&self->old);
+        }
+        out->avg_hit_probe = out->live ? (double)probe_sum / (double)out->live : 0.0;
+        if (self->arena) {
+            for (const arena_chunk *c = self->arena->chunks; c; c = c->next) {
+                out->arena_bytes += DICT_ARENA_HDR + DICT_ARENA_CHUNK;
+            }
+        }
+#ifdef DS_STATS
+        out->resizes = self->resizes;
+#endif
+        return DICT_OK;
+    }
 }
 
 /* ---- Debug -------------------------------------------------------------- */
 
+static void table_debug_print(const dict_table *t, const char *label) {
+    for (size_t i = 0; i < t->cap; ++i) {
+        if (ctrl_is_full(t->ctrl[i])) {
+            printf("  %s[%zu] %.*s -> %.*s\n", label, i,
+                   (int)t->slots[i].klen, t->slots[i].key,
+                   (int)t->slots[i].vlen, t->slots[i].value);
+        }
+    }
+}
+
 void dict_debug_print(const dict *self) {
     if (!self) {
         printf("dict(NULL)\n");
         return;
     }
     else {
-        printf("dict(size=%zu, buckets=%zu, load=%zu%%)\n",
-               self->count,
-               self->size,
-               (self->size ? (self->count * 100u / self->size) : 0u));
-        
-        for (size_t i = 0; i < self->size; ++i) {
-            item *it = self->items[i];
-            if (it && it != &DELETED_SENTINEL) {
-                printf("  [%zu] %s -> %s\n", i, it->key, it->value);
-            }
+        printf("dict(size=%zu, buckets=%zu, load=%zu%%, tombstones=%zu)\n",
+               dict_size(self),
+               self->tab.cap,
+               (dict_size(self) * 100u / self->tab.cap),
+               self->tab.deleted);
+        if (dict_rehashing(self)) {
+            printf("  rehashing: %zu of %zu old buckets migrated, %zu entries left\n",
+                   self->migrate_pos, self->old.cap, self->old.count);
+        }
+
+        table_debug_print(&self->tab, "");
+        if (dict_rehashing(self)) {
+            table_debug_print(&self->old, "old");
         }
         return;
     }
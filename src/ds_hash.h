@@ -0,0 +1,184 @@
+#ifndef DS_HASH_H
+#define DS_HASH_H
+
+/* Internal hashing shared by the hash-based containers (dictionary, cdict,
+   fdict, set). Header-only: every function is static inline, so including
+   it from more than one source file (or from the unity build) is safe.
+   - ds_hash64: fast unkeyed hash (wyhash-style). Anyone who can choose keys
+     can precompute collisions for it.
+   - ds_siphash13: SipHash-1-3 keyed by a secret 128-bit key, for tables
+     fed with untrusted keys; ds_hash_random_key draws such a key. */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <bcrypt.h>
+#if defined(_MSC_VER)
+#pragma comment(lib, "bcrypt")
+#endif
+#endif
+
+/* 64-bit hash in the style of wyhash: 16 bytes per multiply-fold step,
+   no per-byte division. Not cryptographic. */
+#define DS_WY0 0xa0761d6478bd642full
+#define DS_WY1 0xe7037ed1a0b428dbull
+#define DS_WY2 0x8ebc6af09c88c6e3ull
+#define DS_WY3 0x589965cc75374cc3ull
+
+/* 64x64 -> 128 multiply, folded to 64 bits by xor of the halves. */
+static inline uint64_t ds_hash_mix(uint64_t a, uint64_t b) {
+#if defined(__SIZEOF_INT128__)
+    __uint128_t r = (__uint128_t)a * b;
+    return (uint64_t)r ^ (uint64_t)(r >> 64);
+#else
+    uint64_t ha = a >> 32, la = (uint32_t)a;
+    uint64_t hb = b >> 32, lb = (uint32_t)b;
+    uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    uint64_t t = rl + (rm0 << 32);
+    uint64_t c = (t < rl);
+    uint64_t lo = t + (rm1 << 32);
+    c += (lo < t);
+    uint64_t hi = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+    return lo ^ hi;
+#endif
+}
+
+static inline uint64_t ds_hash_read64(const unsigned char *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t ds_hash_read32(const unsigned char *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t ds_hash64(const void *key, size_t len, uint64_t seed) {
+    const unsigned char *p = (const unsigned char*)key;
+    uint64_t a;
+    uint64_t b;
+    seed ^= ds_hash_mix(seed ^ DS_WY0, DS_WY1);
+    if (len <= 16) {
+        if (len >= 4) {
+            a = (ds_hash_read32(p) << 32) | ds_hash_read32(p + ((len >> 3) << 2));
+            b = (ds_hash_read32(p + len - 4) << 32) | ds_hash_read32(p + len - 4 - ((len >> 3) << 2));
+        }
+        else if (len > 0) {
+            a = ((uint64_t)p[0] << 16) | ((uint64_t)p[len >> 1] << 8) | p[len - 1];
+            b = 0;
+        }
+        else {
+            a = 0;
+            b = 0;
+        }
+    }
+    else {
+        size_t i = len;
+        if (i > 48) {
+            uint64_t see1 = seed;
+            uint64_t see2 = seed;
+            do {
+                seed = ds_hash_mix(ds_hash_read64(p) ^ DS_WY1, ds_hash_read64(p + 8) ^ seed);
+                see1 = ds_hash_mix(ds_hash_read64(p + 16) ^ DS_WY2, ds_hash_read64(p + 24) ^ see1);
+                see2 = ds_hash_mix(ds_hash_read64(p + 32) ^ DS_WY3, ds_hash_read64(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= see1 ^ see2;
+        }
+        while (i > 16) {
+            seed = ds_hash_mix(ds_hash_read64(p) ^ DS_WY1, ds_hash_read64(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+        a = ds_hash_read64(p + i - 16);
+        b = ds_hash_read64(p + i - 8);
+    }
+    return ds_hash_mix(DS_WY1 ^ (uint64_t)len, ds_hash_mix(a ^ DS_WY1, b ^ seed));
+}
+
+/* SipHash with c compression and d finalization rounds (Aumasson and
+   Bernstein). Words are read in native byte order, so on big-endian hosts
+   the output differs from the reference vectors (it is no weaker). */
+#define DS_SIP_ROTL(x, b) (uint64_t)(((x) << (b)) | ((x) >> (64 - (b))))
+
+static inline void ds_sip_round(uint64_t v[4]) {
+    v[0] += v[1]; v[1] = DS_SIP_ROTL(v[1], 13); v[1] ^= v[0]; v[0] = DS_SIP_ROTL(v[0], 32);
+    v[2] += v[3]; v[3] = DS_SIP_ROTL(v[3], 16); v[3] ^= v[2];
+    v[0] += v[3]; v[3] = DS_SIP_ROTL(v[3], 21); v[3] ^= v[0];
+    v[2] += v[1]; v[1] = DS_SIP_ROTL(v[1], 17); v[1] ^= v[2]; v[2] = DS_SIP_ROTL(v[2], 32);
+}
+
+static inline uint64_t ds_siphash(const void *key, size_t len, uint64_t k0, uint64_t k1,
+                                  unsigned c, unsigned d) {
+    const unsigned char *p = (const unsigned char*)key;
+    uint64_t v[4];
+    v[0] = k0 ^ 0x736f6d6570736575ull;
+    v[1] = k1 ^ 0x646f72616e646f6dull;
+    v[2] = k0 ^ 0x6c7967656e657261ull;
+    v[3] = k1 ^ 0x7465646279746573ull;
+    size_t left = len;
+    while (left >= 8) {
+        uint64_t m = ds_hash_read64(p);
+        v[3] ^= m;
+        for (unsigned r = 0; r < c; ++r) {
+            ds_sip_round(v);
+        }
+        v[0] ^= m;
+        p += 8;
+        left -= 8;
+    }
+    uint64_t b = (uint64_t)len << 56;
+    for (size_t i = 0; i < left; ++i) {
+        b |= (uint64_t)p[i] << (8 * i);
+    }
+    v[3] ^= b;
+    for (unsigned r = 0; r < c; ++r) {
+        ds_sip_round(v);
+    }
+    v[0] ^= b;
+    v[2] ^= 0xff;
+    for (unsigned r = 0; r < d; ++r) {
+        ds_sip_round(v);
+    }
+    return v[0] ^ v[1] ^ v[2] ^ v[3];
+}
+
+static inline uint64_t ds_siphash13(const void *key, size_t len, uint64_t k0, uint64_t k1) {
+    return ds_siphash(key, len, k0, k1, 1u, 3u);
+}
+
+/* Fills key[0..1] with a fresh secret from the OS: BCryptGenRandom on
+   Windows, /dev/urandom elsewhere. Only if that fails does it fall back to
+   clock, time and the stack and key addresses run through the
+   multiply-fold mix (guessable; no shared state, so thread-safe). */
+static inline void ds_hash_random_key(uint64_t key[2]) {
+    size_t got = 0;
+#if defined(_WIN32)
+    if (BCryptGenRandom(NULL, (PUCHAR)key, (ULONG)(2u * sizeof(uint64_t)),
+                        BCRYPT_USE_SYSTEM_PREFERRED_RNG) == 0) {
+        got = 2;
+    }
+#else
+    FILE *fp = fopen("/dev/urandom", "rb");
+    if (fp) {
+        got = fread(key, sizeof(uint64_t), 2, fp);
+        fclose(fp);
+    }
+#endif
+    if (got != 2) {
+        uint64_t a = (uint64_t)time(NULL) ^ ((uint64_t)clock() << 32);
+        uint64_t b = (uint64_t)(uintptr_t)&got ^ ((uint64_t)(uintptr_t)key * DS_WY3);
+        key[0] = ds_hash_mix(a ^ DS_WY0, b ^ DS_WY1);
+        key[1] = ds_hash_mix(key[0] ^ DS_WY2, b ^ a ^ DS_WY3);
+    }
+}
+
+#endif /* DS_HASH_H */
@@ -0,0 +1,479 @@
+#include "fdict.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+
+#include "ds_hash.h"
+
+#if !defined(_WIN32)
+#define FDICT_HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define FDICT_HAVE_MMAP 0
+#endif
+
+/* Image layout (native byte order, all offsets from the start of the file):
+     header   64 bytes (fdict_header, zero padded)
+     disp     buckets x uint32 displacement words
+     slots    count x fdict_slot, 8-byte aligned
+     data     per slot: key bytes, NUL, value bytes, NUL
+   Perfect hash (CHD, hash-and-displace) with exactly one slot per key:
+   - h = ds_hash64(key, seed); the high 32 bits pick one of ~count/2
+     buckets. Each bucket stores one displacement word.
+   - For an ordinary word d the key lives at fdict_pos(h, d). The builder
+     places buckets largest first and searches for the smallest d that sends
+     every key of the bucket to a free slot.
+   - Single-key buckets are placed last and need no search: their word is
+     FDICT_DIRECT | slot and names any slot left over. This is what lets the
+     table be completely full without a long search for the last keys.
+   - If some bucket exhausts FDICT_MAX_DISP the build retries with another
+     seed. */
+
+typedef struct fdict_header {
+    uint64_t magic;
+    uint64_t count;      /* keys == slots */
+    uint64_t buckets;
+    uint64_t seed;
+    uint64_t disp_off;
+    uint64_t slots_off;
+    uint64_t data_off;
+    uint64_t size;       /* file size in bytes */
+} fdict_header;
+
+typedef struct fdict_slot {
+    uint64_t off;        /* key offset within the data section */
+    uint32_t klen;
+    uint32_t vlen;       /* value follows the key's NUL */
+} fdict_slot;
+
+struct fdict {
+    void              *base;
+    size_t             len;
+    size_t             count;
+    size_t             buckets;
+    uint64_t           seed;
+    const uint32_t    *disp;
+    const fdict_slot  *slots;
+    const char        *data;
+};
+
+#define FDICT_MAGIC        0x3154434944465344ull /* "DSFDICT1" */
+#define FDICT_HEADER_BYTES 64u
+#define FDICT_BUCKET_LOAD  2u            /* average keys per bucket */
+#define FDICT_DIRECT       0x80000000u   /* displacement word holds a slot index */
+#define FDICT_MAX_DISP     (1u << 20)
+#define FDICT_MAX_SEEDS    16u
+
+/* ---- internal helpers --------------------------------------------------- */
+
+/* Maps the high half of h onto [0, buckets) without a division. */
+static size_t fdict_bucket(uint64_t h, size_t buckets) {
+    return (size_t)(((h >> 32) * (uint64_t)buckets) >> 32);
+}
+
+/* Slot for h under displacement d; count < 2^31, so the same
+   multiply-shift reduction as fdict_bucket applies. */
+static size_t fdict_pos(uint64_t h, uint32_t d, size_t count) {
+    uint64_t x = ds_hash_mix(h ^ DS_WY2, DS_WY3 ^ d);
+    return (size_t)(((x >> 32) * (uint64_t)count) >> 32);
+}
+
+static size_t fdict_slot_of(const fdict *f, uint64_t h) {
+    uint32_t d = f->disp[fdict_bucket(h, f->buckets)];
+    if (d & FDICT_DIRECT) {
+        return (size_t)(d & ~FDICT_DIRECT);
+    }
+    else {
+        return fdict_pos(h, d, f->count);
+    }
+}
+
+/* ---- internal: building ------------------------------------------------- */
+
+typedef struct fdict_entry {
+    const char *key;
+    const char *value;
+    size_t      klen;
+    size_t      vlen;
+    uint64_t    hash;
+} fdict_entry;
+
+typedef struct fdict_build {
+    fdict_entry *entries;
+    size_t       count;
+    size_t       buckets;
+    uint64_t     seed;
+    size_t      *start;    /* buckets + 1 offsets into members */
+    size_t      *members;  /* entry indices grouped by bucket */
+    uint64_t    *order;    /* (bucket size << 32) | bucket, largest first */
+    uint32_t    *disp;
+    uint32_t    *slot_entry; /* entry index per slot */
+    uint8_t     *taken;
+} fdict_build;
+
+static int fdict_cmp_desc(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return (x < y) - (x > y);
+}
+
+/* Tries to place every key with b->seed. Returns false if some bucket
+   could not be displaced into free slots. */
+static bool fdict_place(fdict_build *b) {
+    size_t n = b->count;
+    memset(b->start, 0, (b->buckets + 1) * sizeof(size_t));
+    memset(b->taken, 0, n);
+    for (size_t i = 0; i < n; ++i) {
+        fdict_entry *e = &b->entries[i];
+        e->hash = ds_hash64(e->key, e->klen, b->seed);
+        ++b->start[fdict_bucket(e->hash, b->buckets) + 1];
+    }
+    for (size_t k = 0; k < b->buckets; ++k) {
+        b->order[k] = ((uint64_t)b->start[k + 1] << 32) | k;
+        b->start[k + 1] += b->start[k];
+    }
+    /* members: counting sort by bucket, reusing slot_entry as fill cursors */
+    for (size_t k = 0; k < b->buckets; ++k) {
+        b->slot_entry[k] = 0;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        size_t k = fdict_bucket(b->entries[i].hash, b->buckets);
+        b->members[b->start[k] + b->slot_entry[k]++] = i;
+    }
+    qsort(b->order, b->buckets, sizeof(uint64_t), fdict_cmp_desc);
+
+    size_t next_free = 0;
+    for (size_t o = 0; o < b->buckets; ++o) {
+        size_t k = (size_t)(b->order[o] & 0xFFFFFFFFu);
+        size_t size = (size_t)(b->order[o] >> 32);
+        const size_t *m = &b->members[b->start[k]];
+        if (size == 0) {
+            b->disp[k] = 0;
+        }
+        else if (size == 1) {
+            while (b->taken[next_free]) {
+                ++next_free;
+            }
+            b->taken[next_free] = 1;
+            b->slot_entry[next_free] = (uint32_t)m[0];
+            b->disp[k] = FDICT_DIRECT | (uint32_t)next_free;
+        }
+        else {
+            uint32_t d = 0;
+            for (; d < FDICT_MAX_DISP; ++d) {
+                size_t j = 0;
+                for (; j < size; ++j) {
+                    size_t p = fdict_pos(b->entries[m[j]].hash, d, n);
+                    if (b->taken[p]) {
+                        break;
+                    }
+                    else {
+                        b->taken[p] = 1;
+                    }
+                }
+                if (j == size) {
+                    break;
+                }
+                else {
+                    while (j > 0) { /* roll back this attempt */
+                        --j;
+                        b->taken[fdict_pos(b->entries[m[j]].hash, d, n)] = 0;
+                    }
+                }
+            }
+            if (d == FDICT_MAX_DISP) {
+                return false;
+            }
+            else {
+                b->disp[k] = d;
+                for (size_t j = 0; j < size; ++j) {
+                    b->slot_entry[fdict_pos(b->entries[m[j]].hash, d, n)] = (uint32_t)m[j];
+                }
+            }
+        }
+    }
+    return true;
+}
+
+static void fdict_build_release(fdict_build *b) {
+    free(b->entries);
+    free(b->start);
+    free(b->members);
+    free(b->order);
+    free(b->disp);
+    free(b->slot_entry);
+    free(b->taken);
+}
+
+static bool fdict_write_all(FILE *fp, const void *p, size_t n) {
+    return n == 0 || fwrite(p, 1, n, fp) == n;
+}
+
+static int fdict_write(const fdict_build *b, const char *path) {
+    size_t n = b->count;
+    uint64_t disp_off = FDICT_HEADER_BYTES;
+    uint64_t slots_off = (disp_off + (uint64_t)b->buckets * sizeof(uint32_t) + 7u) & ~(uint64_t)7u;
+    uint64_t data_off = slots_off + (uint64_t)n * sizeof(fdict_slot);
+    uint64_t data_len = 0;
+    for (size_t i = 0; i < n; ++i) {
+        data_len += b->entries[i].klen + b->entries[i].vlen + 2u;
+    }
+
+    unsigned char head[FDICT_HEADER_BYTES];
+    fdict_header h;
+    h.magic = FDICT_MAGIC;
+    h.count = n;
+    h.buckets = b->buckets;
+    h.seed = b->seed;
+    h.disp_off = disp_off;
+    h.slots_off = slots_off;
+    h.data_off = data_off;
+    h.size = data_off + data_len;
+    memset(head, 0, sizeof(head));
+    memcpy(head, &h, sizeof(h));
+
+    /* written beside the target and renamed over it, so readers that
+       still map the old image keep a complete file, and a failed write
+       leaves the old image untouched */
+    size_t plen = strlen(path);
+    char *tmp = (char*)malloc(plen + sizeof(".tmp"));
+    if (!tmp) {
+        return FDICT_ERR_OOM;
+    }
+    memcpy(tmp, path, plen);
+    memcpy(tmp + plen, ".tmp", sizeof(".tmp"));
+    FILE *fp = fopen(tmp, "wb");
+    if (!fp) {
+        free(tmp);
+        return FDICT_ERR_IO;
+    }
+    static const unsigned char zeros[8] = {0};
+    size_t pad = (size_t)(slots_off - disp_off - b->buckets * sizeof(uint32_t));
+    bool ok = fdict_write_all(fp, head, sizeof(head)) &&
+              fdict_write_all(fp, b->disp, b->buckets * sizeof(uint32_t)) &&
+              fdict_write_all(fp, zeros, pad);
+
+    /* slots and data both follow slot order, so neighbouring slots point at
+       neighbouring bytes */
+    uint64_t off = 0;
+    for (size_t s = 0; ok && s < n; ++s) {
+        const fdict_entry *e = &b->entries[b->slot_entry[s]];
+        fdict_slot rec;
+        rec.off = off;
+        rec.klen = (uint32_t)e->klen;
+        rec.vlen = (uint32_t)e->vlen;
+        ok = fdict_write_all(fp, &rec, sizeof(rec));
+        off += e->klen + e->vlen + 2u;
+    }
+    for (size_t s = 0; ok && s < n; ++s) {
+        const fdict_entry *e = &b->entries[b->slot_entry[s]];
+        ok = fdict_write_all(fp, e->key, e->klen) && fdict_write_all(fp, zeros, 1) &&
+             fdict_write_all(fp, e->value, e->vlen) && fdict_write_all(fp, zeros, 1);
+    }
+
+    ok = fflush(fp) == 0 && ok;
+    if (fclose(fp) != 0 || !ok) {
+        remove(tmp);
+        free(tmp);
+        return FDICT_ERR_IO;
+    }
+#if defined(_WIN32)
+    remove(path); /* rename does not replace an existing file here */
+#endif
+    if (rename(tmp, path) != 0) {
+        remove(tmp);
+        free(tmp);
+        return FDICT_ERR_IO;
+    }
+    else {
+        free(tmp);
+        return FDICT_OK;
+    }
+}
+
+int dict_freeze(const dict *d, const char *path) {
+    if (!d || !path) {
+        return FDICT_ERR_IO;
+    }
+
+    fdict_build b;
+    memset(&b, 0, sizeof(b));
+    b.count = dict_size(d);
+    if (b.count >= FDICT_DIRECT) {
+        return FDICT_ERR_IO; /* slot indices must fit below the direct flag */
+    }
+    b.buckets = b.count / FDICT_BUCKET_LOAD + 1;
+    b.entries = (fdict_entry*)malloc((b.count ? b.count : 1) * sizeof(fdict_entry));
+    b.start = (size_t*)malloc((b.buckets + 1) * sizeof(size_t));
+    b.members = (size_t*)malloc((b.count ? b.count : 1) * sizeof(size_t));
+    b.order = (uint64_t*)malloc(b.buckets * sizeof(uint64_t));
+    b.disp = (uint32_t*)calloc(b.buckets, sizeof(uint32_t));
+    /* slot_entry doubles as per-bucket fill cursors while grouping */
+    b.slot_entry = (uint32_t*)malloc((b.count > b.buckets ? b.count : b.buckets) * sizeof(uint32_t));
+    b.taken = (uint8_t*)malloc(b.count ? b.count : 1);
+    if (!b.entries || !b.start || !b.members || !b.order || !b.disp || !b.slot_entry || !b.taken) {
+        fdict_build_release(&b);
+        return FDICT_ERR_OOM;
+    }
+
+    size_t cursor = 0;
+    size_t i = 0;
+    fdict_entry *e = b.entries;
+    while (i < b.count && dict_next(d, &cursor, &e[i].key, &e[i].klen, &e[i].value, &e[i].vlen)) {
+        if (e[i].klen > UINT32_MAX || e[i].vlen > UINT32_MAX) {
+            fdict_build_release(&b);
+            return FDICT_ERR_IO; /* not representable in a slot record */
+        }
+        else {
+            ++i;
+        }
+    }
+
+    bool placed = (b.count == 0);
+    for (unsigned attempt = 0; !placed && attempt < FDICT_MAX_SEEDS; ++attempt) {
+        b.seed = ds_hash_mix(DS_WY0 ^ attempt, DS_WY1);
+        placed = fdict_place(&b);
+    }
+    int rc = placed ? fdict_write(&b, path) : FDICT_ERR_IO;
+    fdict_build_release(&b);
+    return rc;
+}
+
+/* ---- Lifecycle ---------------------------------------------------------- */
+
+#if FDICT_HAVE_MMAP
+/* Checks the header and every slot record against the mapped length, so
+   lookups never need bounds checks beyond the slot index. */
+static bool fdict_validate(const fdict_header *h, size_t len) {
+    if (h->magic != FDICT_MAGIC || h->size != len || h->count >= FDICT_DIRECT ||
+        h->buckets == 0 || h->buckets > UINT32_MAX || h->disp_off != FDICT_HEADER_BYTES) {
+        return false;
+    }
+    else {
+        /* offsets come from the file: compare by subtraction so a crafted
+           value cannot wrap a sum past the checks */
+        return h->slots_off % 8u == 0 &&
+               h->slots_off >= h->disp_off && h->slots_off <= len &&
+               h->buckets <= (h->slots_off - h->disp_off) / sizeof(uint32_t) &&
+               h->count <= (len - h->slots_off) / sizeof(fdict_slot) &&
+               h->data_off >= h->slots_off + h->count * sizeof(fdict_slot) &&
+               h->data_off <= len;
+    }
+}
+#endif
+
+fdict *fdict_open(const char *path) {
+#if FDICT_HAVE_MMAP
+    if (!path) {
+        return NULL;
+    }
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (uint64_t)st.st_size < FDICT_HEADER_BYTES ||
+        (uint64_t)st.st_size > SIZE_MAX) {
+        close(fd);
+        return NULL;
+    }
+    size_t len = (size_t)st.st_size;
+    void *base = mmap(NULL, len, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd); /* the mapping keeps the file alive */
+    if (base == MAP_FAILED) {
+        return NULL;
+    }
+
+    fdict_header h;
+    memcpy(&h, base, sizeof(h));
+    fdict *f = fdict_validate(&h, len) ? (fdict*)malloc(sizeof(fdict)) : NULL;
+    if (!f) {
+        munmap(base, len);
+        return NULL;
+    }
+    f->base = base;
+    f->len = len;
+    f->count = (size_t)h.count;
+    f->buckets = (size_t)h.buckets;
+    f->seed = h.seed;
+    f->disp = (const uint32_t*)((const char*)base + h.disp_off);
+    f->slots = (const fdict_slot*)((const char*)base + h.slots_off);
+    f->data = (const char*)base + h.data_off;
+
+    uint64_t data_len = len - h.data_off;
+    for (size_t s = 0; s < f->count; ++s) {
+        const fdict_slot *r = &f->slots[s];
+        if (r->off > data_len || data_len - r->off < (uint64_t)r->klen + r->vlen + 2u) {
+            fdict_close(f);
+            return NULL;
+        }
+    }
+    return f;
+#else
+    (void)path;
+    return NULL;
+#endif
+}
+
+void fdict_close(fdict *f) {
+    if (!f) {
+        return;
+    }
+    else {
+#if FDICT_HAVE_MMAP
+        munmap(f->base, f->len);
+#endif
+        free(f);
+    }
+}
+
+/* ---- Queries ------------------------------------------------------------ */
+
+size_t fdict_size(const fdict *f) {
+    return f ? f->count : 0;
+}
+
+bool fdict_contains(const fdict *f, const char *key) {
+    return fdict_get(f, key, NULL) == FDICT_OK;
+}
+
+/* ---- Lookups ------------------------------------------------------------ */
+
+int fdict_get(const fdict *f, const char *key, const char **out_value) {
+    if (!key) {
+        return FDICT_ERR_NOTFOUND;
+    }
+    else {
+        return fdict_get_n(f, key, strlen(key), out_value, NULL);
+    }
+}
+
+int fdict_get_n(const fdict *f, const void *key, size_t klen,
+                const char **out_value, size_t *out_vlen) {
+    if (!f || !key || f->count == 0) {
+        return FDICT_ERR_NOTFOUND;
+    }
+    size_t s = fdict_slot_of(f, ds_hash64(key, klen, f->seed));
+    if (s >= f->count) {
+        return FDICT_ERR_NOTFOUND; /* corrupt direct index */
+    }
+    const fdict_slot *r = &f->slots[s];
+    const char *k = f->data + r->off;
+    if (r->klen != klen || memcmp(k, key, klen) != 0) {
+        return FDICT_ERR_NOTFOUND;
+    }
+    else {
+        if (out_value) {
+            *out_value = k + klen + 1;
+        }
+        if (out_vlen) {
+            *out_vlen = r->vlen;
+        }
+        return FDICT_OK;
+    }
+}
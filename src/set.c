@@ -2,6 +2,9 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdint.h>
+
+#include "ds_hash.h"
 
 /* ---- internal types ----------------------------------------------------- */
 
@@ -14,6 +17,8 @@ struct set {
     size_t  size;     /* number of buckets (prime) */
     size_t  count;    /* stored entries */
     item  **items;    /* buckets: NULL / &DELETED_SENTINEL / heap item */
+    int     hash_mode;   /* SET_HASH_* */
+    uint64_t hash_key[2]; /* SipHash key (SET_HASH_SIPHASH only) */
 };
 
 /* ---- constants ---------------------------------------------------------- */
@@ -91,10 +96,30 @@ static unsigned hash_poly(const char *s, unsigned a, unsigned m) {
     return (unsigned)h;
 }
 
-static unsigned bucket_index(const char *s, unsigned m, unsigned attempt) {
-    unsigned h1 = hash_poly(s, PRIME_1, m);
-    unsigned h2 = hash_poly(s, PRIME_2, m);
-    return (h1 + attempt * (h2 + 1u)) % m;
+/* Double hashing. Returns the first bucket and stores the probe step in
+   *step; the key is hashed once per operation and later buckets come from
+   bucket_next. With SET_HASH_SIPHASH both values come from one keyed
+   64-bit hash, so an attacker cannot aim keys at a probe chain. */
+static unsigned bucket_first(const set *self, const char *s, unsigned m, unsigned *step) {
+    unsigned h1;
+    unsigned h2;
+    if (self->hash_mode == SET_HASH_SIPHASH) {
+        uint64_t h = ds_siphash13(s, strlen(s), self->hash_key[0], self->hash_key[1]);
+        h1 = (unsigned)((uint32_t)h % m);
+        h2 = (unsigned)((h >> 32) % m);
+    }
+    else {
+        h1 = hash_poly(s, PRIME_1, m);
+        h2 = hash_poly(s, PRIME_2, m);
+    }
+    /* step in [1, m-1]: never a multiple of the prime m, so the probe
+       sequence visits every bucket (h2 + 1 == m used to step in place) */
+    *step = h2 % (m - 1u) + 1u;
+    return h1;
+}
+
+static unsigned bucket_next(unsigned idx, unsigned step, unsigned m) {
+    return (unsigned)(((unsigned long long)idx + step) % m);
 }
 
 static item *item_new(const char *k) {
@@ -128,7 +153,7 @@ static void item_free(item *it) {
 /* ---- table management --------------------------------------------------- */
 
 static set *set_new_sized(size_t base_size) {
-    set *s = (set*)malloc(sizeof(*s));
+    set *s = (set*)calloc(1, sizeof(*s));
     if (!s) {
         return NULL;
     }
@@ -148,9 +173,9 @@ static set *set_new_sized(size_t base_size) {
 }
 
 static int set_insert_raw(set *self, item *it) {
-    unsigned attempt = 0;
     unsigned m = (unsigned)self->size;
-    unsigned idx = bucket_index(it->key, m, attempt);
+    unsigned step;
+    unsigned idx = bucket_first(self, it->key, m, &step);
 
     while (self->items[idx] && self->items[idx] != &DELETED_SENTINEL) {
         if (strcmp(self->items[idx]->key, it->key) == 0) {
@@ -158,8 +183,7 @@ static int set_insert_raw(set *self, item *it) {
             self->items[idx] = it;
             return SET_OK;
         }
-        attempt++;
-        idx = bucket_index(it->key, m, attempt);
+        idx = bucket_next(idx, step, m);
     }
     self->items[idx] = it;
     self->count++;
@@ -176,6 +200,9 @@ static int set_resize(set *self, size_t new_base_size) {
             return SET_ERR_OOM;
         }
         else {
+            ns->hash_mode = self->hash_mode; /* rehash with the same function */
+            ns->hash_key[0] = self->hash_key[0];
+            ns->hash_key[1] = self->hash_key[1];
             for (size_t i = 0; i < self->size; ++i) {
                 item *it = self->items[i];
                 if (it && it != &DELETED_SENTINEL) {
@@ -219,6 +246,20 @@ set *set_new(void) {
     return set_new_sized(SET_INIT_BASE_SIZE);
 }
 
+set *set_new_with_hash(int mode) {
+    if (mode != SET_HASH_POLY && mode != SET_HASH_SIPHASH) {
+        return NULL;
+    }
+    set *s = set_new_sized(SET_INIT_BASE_SIZE);
+    if (s) {
+        s->hash_mode = mode;
+        if (mode == SET_HASH_SIPHASH) {
+            ds_hash_random_key(s->hash_key);
+        }
+    }
+    return s;
+}
+
 void set_dispose(set *self) {
     if (!self) {
         return;
@@ -247,9 +288,9 @@ bool set_contains(const set *self, const char *key) {
         return false;
     }
     else {
-        unsigned attempt = 0;
         unsigned m = (unsigned)self->size;
-        unsigned idx = bucket_index(key, m, attempt);
+        unsigned step;
+        unsigned idx = bucket_first(self, key, m, &step);
 
         item *it = self->items[idx];
         while (it) {
@@ -258,8 +299,7 @@ bool set_contains(const set *self, const char *key) {
                     return true;
                 }
             }
-            attempt++;
-            idx = bucket_index(key, m, attempt);
+            idx = bucket_next(idx, step, m);
             it = self->items[idx];
         }
         return false;
@@ -304,9 +344,9 @@ int set_remove(set *self, const char *key) {
         return SET_ERR_NOTFOUND;
     }
     else {
-        unsigned attempt = 0;
         unsigned m = (unsigned)self->size;
-        unsigned idx = bucket_index(key, m, attempt);
+        unsigned step;
+        unsigned idx = bucket_first(self, key, m, &step);
 
         item *it = self->items[idx];
         while (it) {
@@ -324,8 +364,7 @@ int set_remove(set *self, const char *key) {
                     return SET_OK;
                 }
             }
-            attempt++;
-            idx = bucket_index(key, m, attempt);
+            idx = bucket_next(idx, step, m);
             it = self->items[idx];
         }
         return SET_ERR_NOTFOUND;
@@ -5,22 +5,167 @@
 #include <stdio.h>
 #include <stdint.h>
 
+#if !defined(_WIN32)
+#define VECTOR_HAVE_PTHREADS 1
+#define VECTOR_HAVE_MMAP     1
+#include <pthread.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define VECTOR_HAVE_PTHREADS 0
+#define VECTOR_HAVE_MMAP     0
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define VECTOR_X86_SIMD 1
+#include <immintrin.h>
+#else
+#define VECTOR_X86_SIMD 0
+#endif
+
 /* Internal layout:
    - Backed by a ring buffer (head..tail) for O(1) front/back operations.
    - Growth linearizes elements into a larger contiguous buffer.
-   - Middle insert/remove first linearizes to enable memmove in logical order. */
+   - Middle insert/remove shift whichever side (front or back) is shorter,
+     in place, so they cost O(min(i, n - i)) and never allocate.
+   - Small vectors keep their buffer inline, in the same allocation as the
+     header (inline_buf); data points there until growth moves it to the heap.
+   - Mapped vectors keep the ring inside an mmap'd file (map_base != NULL),
+     right after a fixed-size header; growth extends the file in place. */
 struct vector {
     size_t size;
     size_t capacity;
     size_t head;   /* index of first element when size > 0 */
     size_t tail;   /* index of last  element when size > 0 */
-    int   *data;
+    int   *data;   /* inline_buf, a heap buffer, or inside the mapping */
+    void  *map_base;  /* file mapping, NULL for memory-only vectors */
+    size_t map_len;
+    int    map_fd;
+    size_t inline_cap;
+    int    inline_buf[];
 };
 
+/* Inline buffer sizing: every vector gets at least VECTOR_INLINE_MIN slots in
+   its header allocation; explicit capacities up to VECTOR_INLINE_MAX are also
+   kept inline, larger ones get a separate exactly-sized buffer. */
+#define VECTOR_INLINE_MIN 16
+#define VECTOR_INLINE_MAX 256
+
+/* On-disk header of a mapped vector. The ring buffer follows at offset
+   VECTOR_MAP_HEADER_BYTES; tail is derived from head and size. The fields
+   are refreshed by vector_sync and vector_free. */
+typedef struct vector_map_header {
+    uint64_t magic;
+    uint64_t head;
+    uint64_t size;
+    uint64_t capacity;
+} vector_map_header;
+
+#define VECTOR_MAP_MAGIC        0x3152544345565344ull /* "DSVECTR1" */
+#define VECTOR_MAP_HEADER_BYTES 64u
+#define VECTOR_MAP_INIT_CAP     1024u
+
 /* ---- internal helpers --------------------------------------------------- */
 
+/* Copies count elements starting at ring position pos into dst.
+   At most two memcpy calls: up to the wrap point, then from index 0. */
+static void vector_ring_read(const vector *v, size_t pos, size_t count, int *dst) {
+    size_t first = v->capacity - pos;
+    if (first > count) {
+        first = count;
+    }
+    memcpy(dst, &v->data[pos], first * sizeof(int));
+    memcpy(dst + first, v->data, (count - first) * sizeof(int));
+}
+
+/* Copies count elements from src into the ring starting at position pos.
+   Mirror image of vector_ring_read. */
+static void vector_ring_write(vector *v, size_t pos, const int *src, size_t count) {
+    size_t first = v->capacity - pos;
+    if (first > count) {
+        first = count;
+    }
+    memcpy(&v->data[pos], src, first * sizeof(int));
+    memcpy(v->data, src + first, (count - first) * sizeof(int));
+}
+
+/* Reverses p[0..n) in place; building block for rotation. */
+static void vector_reverse(int *p, size_t n) {
+    size_t i = 0;
+    size_t j = n;
+    while (i + 1 < j) {
+        --j;
+        int t = p[i];
+        p[i] = p[j];
+        p[j] = t;
+        ++i;
+    }
+}
+
+/* ---- file mapping ------------------------------------------------------- */
+
+#if VECTOR_HAVE_MMAP
+static void vector_map_store_header(vector *v) {
+    vector_map_header *h = (vector_map_header*)v->map_base;
+    h->magic = VECTOR_MAP_MAGIC;
+    h->head = v->head;
+    h->size = v->size;
+    h->capacity = v->capacity;
+}
+
+/* Extends the backing file and mapping to hold new_cap elements.
+   The ring keeps its head; a wrapped front segment is moved to the end of
+   the enlarged buffer so the logical order survives. */
+static int vector_map_grow(vector *v, size_t new_cap) {
+    if (new_cap > (SIZE_MAX - VECTOR_MAP_HEADER_BYTES) / sizeof(int)) {
+        return VECTOR_ERR_OOM;
+    }
+
+    size_t new_len = VECTOR_MAP_HEADER_BYTES + new_cap * sizeof(int);
+    if (ftruncate(v->map_fd, (off_t)new_len) != 0) {
+        return VECTOR_ERR_IO;
+    }
+
+#ifdef MREMAP_MAYMOVE
+    void *base = mremap(v->map_base, v->map_len, new_len, MREMAP_MAYMOVE);
+    if (base == MAP_FAILED) {
+        return VECTOR_ERR_OOM;
+    }
+#else
+    void *base = mmap(NULL, new_len, PROT_READ | PROT_WRITE, MAP_SHARED, v->map_fd, 0);
+    if (base == MAP_FAILED) {
+        return VECTOR_ERR_OOM;
+    }
+    munmap(v->map_base, v->map_len);
+#endif
+
+    size_t old_cap = v->capacity;
+    v->map_base = base;
+    v->map_len = new_len;
+    v->data = (int*)((char*)base + VECTOR_MAP_HEADER_BYTES);
+    v->capacity = new_cap;
+
+    if (v->size > 0 && v->head + v->size > old_cap) {
+        size_t front = old_cap - v->head;
+        size_t new_head = new_cap - front;
+        memmove(&v->data[new_head], &v->data[v->head], front * sizeof(int));
+        v->head = new_head;
+    }
+    vector_map_store_header(v);
+    return VECTOR_OK;
+}
+#else
+static int vector_map_grow(vector *v, size_t new_cap) {
+    (void)v;
+    (void)new_cap;
+    return VECTOR_ERR_IO;
+}
+#endif /* VECTOR_HAVE_MMAP */
+
 /* Ensures capacity >= want; keeps logical order and resets head to 0.
-   Uses the old capacity for modulo arithmetic during copying. */
+   The old ring is copied out in at most two segments. */
 static int vector_ensure_capacity(vector *v, size_t want) {
     if (v->capacity >= want) {
         return VECTOR_OK;
@@ -37,22 +182,25 @@ static int vector_ensure_capacity(vector *v, size_t want) {
             }
         }
 
+        if (v->map_base) {
+            return vector_map_grow(v, new_cap);
+        }
+
         int *new_data = (int*)malloc(new_cap * sizeof(int));
         if (!new_data) {
             return VECTOR_ERR_OOM;
         }
         else {
-            if (v->capacity == 0) {
-                /* nothing to copy when size==0 as well */
+            if (v->capacity == 0 || v->size == 0) {
+                /* nothing to copy */
             }
             else {
-                for (size_t i = 0; i < v->size; ++i) {
-                    size_t from = (v->head + i) % v->capacity;
-                    new_data[i] = v->data[from];
-                }
+                vector_ring_read(v, v->head, v->size, new_data);
             }
 
-            free(v->data);
+            if (v->data != v->inline_buf) {
+                free(v->data);
+            }
             v->data = new_data;
             v->capacity = new_cap;
             v->head = 0;
@@ -62,60 +210,699 @@ static int vector_ensure_capacity(vector *v, size_t want) {
     }
 }
 
-/* Reorders the ring buffer so that logical index 0 is at physical index 0.
-   Capacity is preserved. */
-static int vector_linearize(vector *v) {
-    if (v->size == 0 || v->head == 0) {
-        return VECTOR_OK;
+/* Moves count elements from ring position src to ring position dst.
+   Each memmove is clipped so that neither range straddles the wrap point.
+   toward_front selects the copy order: front-to-back when the block moves
+   toward lower logical indices, back-to-front otherwise, so overlapping
+   moves behave like memmove across the whole ring. */
+static void vector_ring_move(vector *v, size_t dst, size_t src, size_t count,
+                             bool toward_front) {
+    size_t cap = v->capacity;
+    if (toward_front) {
+        while (count > 0) {
+            size_t chunk = count;
+            if (chunk > cap - src) {
+                chunk = cap - src;
+            }
+            if (chunk > cap - dst) {
+                chunk = cap - dst;
+            }
+            memmove(&v->data[dst], &v->data[src], chunk * sizeof(int));
+            src = (src + chunk == cap) ? 0 : (src + chunk);
+            dst = (dst + chunk == cap) ? 0 : (dst + chunk);
+            count -= chunk;
+        }
     }
     else {
-        int *buf = (int*)malloc(v->capacity * sizeof(int));
-        if (!buf) {
-            return VECTOR_ERR_OOM;
+        /* walk from the last element of each range */
+        size_t src_last = (src + count - 1) % cap;
+        size_t dst_last = (dst + count - 1) % cap;
+        while (count > 0) {
+            size_t chunk = count;
+            if (chunk > src_last + 1) {
+                chunk = src_last + 1;
+            }
+            if (chunk > dst_last + 1) {
+                chunk = dst_last + 1;
+            }
+            memmove(&v->data[dst_last + 1 - chunk], &v->data[src_last + 1 - chunk],
+                    chunk * sizeof(int));
+            src_last = (src_last < chunk) ? (cap - 1) : (src_last - chunk);
+            dst_last = (dst_last < chunk) ? (cap - 1) : (dst_last - chunk);
+            count -= chunk;
+        }
+    }
+}
+
+/* ---- scan kernels ------------------------------------------------------- */
+
+/* Kernels work on one contiguous segment; callers walk the (at most two)
+   ring segments from vector_spans. On x86 with GCC/Clang the SSE2 and AVX2
+   variants are compiled via target attributes and picked at runtime, so the
+   library itself needs no -m flags. Other targets use the scalar loops. */
+
+enum {
+    VECTOR_SIMD_SCALAR = 0,
+    VECTOR_SIMD_SSE2   = 1,
+    VECTOR_SIMD_AVX2   = 2
+};
+
+static int vector_simd_level(void) {
+#if VECTOR_X86_SIMD
+    if (__builtin_cpu_supports("avx2")) {
+        return VECTOR_SIMD_AVX2;
+    }
+    else if (__builtin_cpu_supports("sse2")) {
+        return VECTOR_SIMD_SSE2;
+    }
+    else {
+        return VECTOR_SIMD_SCALAR;
+    }
+#else
+    return VECTOR_SIMD_SCALAR;
+#endif
+}
+
+/* Returns the index of the first p[i] == value, or n when absent. */
+static size_t vector_find_scalar(const int *p, size_t n, int value) {
+    for (size_t i = 0; i < n; ++i) {
+        if (p[i] == value) {
+            return i;
+        }
+    }
+    return n;
+}
+
+static size_t vector_count_scalar(const int *p, size_t n, int value) {
+    size_t c = 0;
+    for (size_t i = 0; i < n; ++i) {
+        c += (p[i] == value);
+    }
+    return c;
+}
+
+#if VECTOR_X86_SIMD
+__attribute__((target("sse2")))
+static size_t vector_find_sse2(const int *p, size_t n, int value) {
+    __m128i key = _mm_set1_epi32(value);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(p + i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(p + i + 4));
+        unsigned ma = (unsigned)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(a, key)));
+        unsigned mb = (unsigned)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(b, key)));
+        unsigned m = ma | (mb << 4);
+        if (m) {
+            return i + (size_t)__builtin_ctz(m);
+        }
+    }
+    return i + vector_find_scalar(p + i, n - i, value);
+}
+
+__attribute__((target("sse2")))
+static size_t vector_count_sse2(const int *p, size_t n, int value) {
+    __m128i key = _mm_set1_epi32(value);
+    size_t c = 0;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(p + i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(p + i + 4));
+        unsigned ma = (unsigned)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(a, key)));
+        unsigned mb = (unsigned)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(b, key)));
+        c += (size_t)__builtin_popcount(ma | (mb << 4));
+    }
+    return c + vector_count_scalar(p + i, n - i, value);
+}
+
+__attribute__((target("avx2")))
+static size_t vector_find_avx2(const int *p, size_t n, int value) {
+    __m256i key = _mm256_set1_epi32(value);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(p + i));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(p + i + 8));
+        unsigned ma = (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(a, key)));
+        unsigned mb = (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(b, key)));
+        unsigned m = ma | (mb << 8);
+        if (m) {
+            return i + (size_t)__builtin_ctz(m);
+        }
+    }
+    return i + vector_find_sse2(p + i, n - i, value);
+}
+
+__attribute__((target("avx2")))
+static size_t vector_count_avx2(const int *p, size_t n, int value) {
+    __m256i key = _mm256_set1_epi32(value);
+    size_t c = 0;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(p + i));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(p + i + 8));
+        unsigned ma = (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(a, key)));
+        unsigned mb = (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(b, key)));
+        c += (size_t)__builtin_popcount(ma | (mb << 8));
+    }
+    return c + vector_count_sse2(p + i, n - i, value);
+}
+#endif /* VECTOR_X86_SIMD */
+
+static size_t vector_find_kernel(const int *p, size_t n, int value) {
+    switch (vector_simd_level()) {
+#if VECTOR_X86_SIMD
+    case VECTOR_SIMD_AVX2:
+        return vector_find_avx2(p, n, value);
+    case VECTOR_SIMD_SSE2:
+        return vector_find_sse2(p, n, value);
+#endif
+    default:
+        return vector_find_scalar(p, n, value);
+    }
+}
+
+static size_t vector_count_kernel(const int *p, size_t n, int value) {
+    switch (vector_simd_level()) {
+#if VECTOR_X86_SIMD
+    case VECTOR_SIMD_AVX2:
+        return vector_count_avx2(p, n, value);
+    case VECTOR_SIMD_SSE2:
+        return vector_count_sse2(p, n, value);
+#endif
+    default:
+        return vector_count_scalar(p, n, value);
+    }
+}
+
+/* ---- arithmetic kernels ------------------------------------------------- */
+
+static int64_t vector_sum_scalar(const int *p, size_t n) {
+    int64_t acc = 0;
+    for (size_t i = 0; i < n; ++i) {
+        acc += p[i];
+    }
+    return acc;
+}
+
+static void vector_min_max_scalar(const int *p, size_t n, int *lo, int *hi) {
+    for (size_t i = 0; i < n; ++i) {
+        if (p[i] < *lo) {
+            *lo = p[i];
+        }
+        if (p[i] > *hi) {
+            *hi = p[i];
+        }
+    }
+}
+
+/* Adds in unsigned arithmetic so overflow wraps instead of being undefined. */
+static void vector_add_scalar_scalar(int *p, size_t n, int delta) {
+    for (size_t i = 0; i < n; ++i) {
+        p[i] = (int)((unsigned)p[i] + (unsigned)delta);
+    }
+}
+
+static void vector_fill_scalar(int *p, size_t n, int value) {
+    for (size_t i = 0; i < n; ++i) {
+        p[i] = value;
+    }
+}
+
+#if VECTOR_X86_SIMD
+__attribute__((target("sse2")))
+static int64_t vector_sum_sse2(const int *p, size_t n) {
+    __m128i acc = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(p + i));
+        __m128i sign = _mm_srai_epi32(x, 31);
+        acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(x, sign));
+        acc = _mm_add_epi64(acc, _mm_unpackhi_epi32(x, sign));
+    }
+    int64_t lanes[2];
+    _mm_storeu_si128((__m128i*)lanes, acc);
+    return lanes[0] + lanes[1] + vector_sum_scalar(p + i, n - i);
+}
+
+/* SSE2 lacks pminsd/pmaxsd; select through a compare mask instead. */
+__attribute__((target("sse2")))
+static void vector_min_max_sse2(const int *p, size_t n, int *lo, int *hi) {
+    if (n < 4) {
+        vector_min_max_scalar(p, n, lo, hi);
+        return;
+    }
+    __m128i vlo = _mm_set1_epi32(*lo);
+    __m128i vhi = _mm_set1_epi32(*hi);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(p + i));
+        __m128i lt = _mm_cmplt_epi32(x, vlo);
+        __m128i gt = _mm_cmpgt_epi32(x, vhi);
+        vlo = _mm_or_si128(_mm_and_si128(lt, x), _mm_andnot_si128(lt, vlo));
+        vhi = _mm_or_si128(_mm_and_si128(gt, x), _mm_andnot_si128(gt, vhi));
+    }
+    int l[4];
+    int h[4];
+    _mm_storeu_si128((__m128i*)l, vlo);
+    _mm_storeu_si128((__m128i*)h, vhi);
+    vector_min_max_scalar(l, 4, lo, hi);
+    vector_min_max_scalar(h, 4, lo, hi);
+    vector_min_max_scalar(p + i, n - i, lo, hi);
+}
+
+__attribute__((target("sse2")))
+static void vector_add_scalar_sse2(int *p, size_t n, int delta) {
+    __m128i d = _mm_set1_epi32(delta);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(p + i));
+        _mm_storeu_si128((__m128i*)(p + i), _mm_add_epi32(x, d));
+    }
+    vector_add_scalar_scalar(p + i, n - i, delta);
+}
+
+__attribute__((target("sse2")))
+static void vector_fill_sse2(int *p, size_t n, int value) {
+    __m128i x = _mm_set1_epi32(value);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_si128((__m128i*)(p + i), x);
+    }
+    vector_fill_scalar(p + i, n - i, value);
+}
+
+__attribute__((target("avx2")))
+static int64_t vector_sum_avx2(const int *p, size_t n) {
+    __m256i acc0 = _mm256_setzero_si256();
+    __m256i acc1 = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(p + i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(p + i + 4));
+        acc0 = _mm256_add_epi64(acc0, _mm256_cvtepi32_epi64(a));
+        acc1 = _mm256_add_epi64(acc1, _mm256_cvtepi32_epi64(b));
+    }
+    int64_t lanes[4];
+    _mm256_storeu_si256((__m256i*)lanes, _mm256_add_epi64(acc0, acc1));
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + vector_sum_scalar(p + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static void vector_min_max_avx2(const int *p, size_t n, int *lo, int *hi) {
+    if (n < 8) {
+        vector_min_max_scalar(p, n, lo, hi);
+        return;
+    }
+    __m256i vlo = _mm256_set1_epi32(*lo);
+    __m256i vhi = _mm256_set1_epi32(*hi);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(p + i));
+        vlo = _mm256_min_epi32(vlo, x);
+        vhi = _mm256_max_epi32(vhi, x);
+    }
+    int l[8];
+    int h[8];
+    _mm256_storeu_si256((__m256i*)l, vlo);
+    _mm256_storeu_si256((__m256i*)h, vhi);
+    vector_min_max_scalar(l, 8, lo, hi);
+    vector_min_max_scalar(h, 8, lo, hi);
+    vector_min_max_scalar(p + i, n - i, lo, hi);
+}
+
+__attribute__((target("avx2")))
+static void vector_add_scalar_avx2(int *p, size_t n, int delta) {
+    __m256i d = _mm256_set1_epi32(delta);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(p + i));
+        _mm256_storeu_si256((__m256i*)(p + i), _mm256_add_epi32(x, d));
+    }
+    vector_add_scalar_scalar(p + i, n - i, delta);
+}
+
+__attribute__((target("avx2")))
+static void vector_fill_avx2(int *p, size_t n, int value) {
+    __m256i x = _mm256_set1_epi32(value);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_si256((__m256i*)(p + i), x);
+    }
+    vector_fill_scalar(p + i, n - i, value);
+}
+#endif /* VECTOR_X86_SIMD */
+
+static int64_t vector_sum_kernel(const int *p, size_t n) {
+    switch (vector_simd_level()) {
+#if VECTOR_X86_SIMD
+    case VECTOR_SIMD_AVX2:
+        return vector_sum_avx2(p, n);
+    case VECTOR_SIMD_SSE2:
+        return vector_sum_sse2(p, n);
+#endif
+    default:
+        return vector_sum_scalar(p, n);
+    }
+}
+
+static void vector_min_max_kernel(const int *p, size_t n, int *lo, int *hi) {
+    switch (vector_simd_level()) {
+#if VECTOR_X86_SIMD
+    case VECTOR_SIMD_AVX2:
+        vector_min_max_avx2(p, n, lo, hi);
+        break;
+    case VECTOR_SIMD_SSE2:
+        vector_min_max_sse2(p, n, lo, hi);
+        break;
+#endif
+    default:
+        vector_min_max_scalar(p, n, lo, hi);
+        break;
+    }
+}
+
+static void vector_add_scalar_kernel(int *p, size_t n, int delta) {
+    switch (vector_simd_level()) {
+#if VECTOR_X86_SIMD
+    case VECTOR_SIMD_AVX2:
+        vector_add_scalar_avx2(p, n, delta);
+        break;
+    case VECTOR_SIMD_SSE2:
+        vector_add_scalar_sse2(p, n, delta);
+        break;
+#endif
+    default:
+        vector_add_scalar_scalar(p, n, delta);
+        break;
+    }
+}
+
+static void vector_fill_kernel(int *p, size_t n, int value) {
+    switch (vector_simd_level()) {
+#if VECTOR_X86_SIMD
+    case VECTOR_SIMD_AVX2:
+        vector_fill_avx2(p, n, value);
+        break;
+    case VECTOR_SIMD_SSE2:
+        vector_fill_sse2(p, n, value);
+        break;
+#endif
+    default:
+        vector_fill_scalar(p, n, value);
+        break;
+    }
+}
+
+/* ---- sorting ------------------------------------------------------------ */
+
+/* Below this many elements insertion sort beats the radix passes. */
+#define VECTOR_SORT_SMALL 64
+/* Parallel sort never gives a thread fewer elements than this. */
+#define VECTOR_SORT_MIN_CHUNK ((size_t)1 << 16)
+
+static void vector_insertion_sort(int *p, size_t n) {
+    for (size_t i = 1; i < n; ++i) {
+        int x = p[i];
+        size_t j = i;
+        while (j > 0 && p[j - 1] > x) {
+            p[j] = p[j - 1];
+            --j;
+        }
+        p[j] = x;
+    }
+}
+
+/* LSD radix sort, 4 passes of 8 bits. Keys are biased by flipping the sign
+   bit so that signed order matches unsigned digit order. Passes whose digit
+   is identical for every key are skipped. tmp must hold n ints. */
+static void vector_radix_sort(int *p, int *tmp, size_t n) {
+    if (n < VECTOR_SORT_SMALL) {
+        vector_insertion_sort(p, n);
+        return;
+    }
+
+    size_t hist[4][256];
+    memset(hist, 0, sizeof(hist));
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t k = (uint32_t)p[i] ^ 0x80000000u;
+        hist[0][k & 0xFFu]++;
+        hist[1][(k >> 8) & 0xFFu]++;
+        hist[2][(k >> 16) & 0xFFu]++;
+        hist[3][k >> 24]++;
+    }
+
+    int *src = p;
+    int *dst = tmp;
+    for (int pass = 0; pass < 4; ++pass) {
+        unsigned shift = (unsigned)pass * 8u;
+        uint32_t first_digit = (((uint32_t)src[0] ^ 0x80000000u) >> shift) & 0xFFu;
+        if (hist[pass][first_digit] == n) {
+            continue; /* every key shares this digit */
+        }
+
+        size_t offs[256];
+        size_t sum = 0;
+        for (int d = 0; d < 256; ++d) {
+            offs[d] = sum;
+            sum += hist[pass][d];
+        }
+        for (size_t i = 0; i < n; ++i) {
+            uint32_t k = (uint32_t)src[i] ^ 0x80000000u;
+            dst[offs[(k >> shift) & 0xFFu]++] = src[i];
+        }
+
+        int *t = src;
+        src = dst;
+        dst = t;
+    }
+
+    if (src != p) {
+        memcpy(p, src, n * sizeof(int));
+    }
+}
+
+/* Merges sorted a[0..na) and b[0..nb) into out. */
+static void vector_merge(const int *a, size_t na, const int *b, size_t nb, int *out) {
+    size_t i = 0;
+    size_t j = 0;
+    size_t k = 0;
+    while (i < na && j < nb) {
+        out[k++] = (b[j] < a[i]) ? b[j++] : a[i++];
+    }
+    memcpy(&out[k], &a[i], (na - i) * sizeof(int));
+    k += na - i;
+    memcpy(&out[k], &b[j], (nb - j) * sizeof(int));
+}
+
+#if VECTOR_HAVE_PTHREADS
+typedef struct vector_sort_job {
+    int   *src;   /* sort: data to sort;  merge: buffer holding both runs */
+    int   *dst;   /* sort: scratch;       merge: output buffer */
+    size_t lo;
+    size_t mid;   /* merge only */
+    size_t hi;
+    bool   merge;
+} vector_sort_job;
+
+static void *vector_sort_worker(void *arg) {
+    vector_sort_job *job = (vector_sort_job*)arg;
+    if (job->merge) {
+        vector_merge(&job->src[job->lo], job->mid - job->lo,
+                     &job->src[job->mid], job->hi - job->mid,
+                     &job->dst[job->lo]);
+    }
+    else {
+        vector_radix_sort(&job->src[job->lo], &job->dst[job->lo], job->hi - job->lo);
+    }
+    return NULL;
+}
+
+/* Runs every job on its own thread; the calling thread takes the last one and
+   also runs any job whose thread could not be created. */
+static void vector_run_jobs(vector_sort_job *jobs, pthread_t *tids, bool *started,
+                            size_t njobs) {
+    for (size_t i = 0; i + 1 < njobs; ++i) {
+        started[i] = (pthread_create(&tids[i], NULL, vector_sort_worker, &jobs[i]) == 0);
+        if (!started[i]) {
+            vector_sort_worker(&jobs[i]);
+        }
+    }
+    vector_sort_worker(&jobs[njobs - 1]);
+    for (size_t i = 0; i + 1 < njobs; ++i) {
+        if (started[i]) {
+            pthread_join(tids[i], NULL);
+        }
+    }
+}
+#endif /* VECTOR_HAVE_PTHREADS */
+
+/* ---- public API --------------------------------------------------------- */
+
+vector *vector_new(void) {
+    return vector_new_with_capacity(0);
+}
+
+vector *vector_new_with_capacity(size_t capacity) {
+    size_t inline_cap = 0;
+    if (capacity <= VECTOR_INLINE_MAX) {
+        inline_cap = (capacity < VECTOR_INLINE_MIN) ? VECTOR_INLINE_MIN : capacity;
+    }
+    else if (capacity > SIZE_MAX / sizeof(int)) {
+        return NULL;
+    }
+
+    vector *v = (vector*)calloc(1, sizeof(*v) + inline_cap * sizeof(int));
+    if (!v) {
+        return NULL;
+    }
+    else {
+        v->inline_cap = inline_cap;
+        if (inline_cap > 0) {
+            v->capacity = inline_cap;
+            v->data = v->inline_buf;
+            return v;
         }
         else {
-            for (size_t i = 0; i < v->size; ++i) {
-                size_t from = (v->head + i) % v->capacity;
-                buf[i] = v->data[from];
+            v->capacity = capacity;
+            v->data = (int*)malloc(capacity * sizeof(int));
+            if (!v->data) {
+                free(v);
+                return NULL;
+            }
+            else {
+                /* size=0, head=0, tail=0 come from calloc */
+                return v;
             }
+        }
+    }
+}
+
+void vector_free(vector *v) {
+    if (!v) {
+        return;
+    }
+    else {
+#if VECTOR_HAVE_MMAP
+        if (v->map_base) {
+            vector_map_store_header(v);
+            munmap(v->map_base, v->map_len);
+            close(v->map_fd);
+            free(v);
+            return;
+        }
+#endif
+        if (v->data != v->inline_buf) {
             free(v->data);
-            v->data = buf;
-            v->head = 0;
-            v->tail = (v->size ? (v->size - 1) : 0);
-            return VECTOR_OK;
         }
+        free(v);
+        return;
     }
 }
 
-/* ---- public API --------------------------------------------------------- */
+vector *vector_open_mapped(const char *path, int flags) {
+#if VECTOR_HAVE_MMAP
+    if (!path) {
+        return NULL;
+    }
+
+    int oflags = O_RDWR;
+    if (flags & VECTOR_MAP_CREATE) {
+        oflags |= O_CREAT;
+    }
+    if (flags & VECTOR_MAP_TRUNCATE) {
+        oflags |= O_TRUNC;
+    }
+    int fd = open(path, oflags, 0644);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return NULL;
+    }
+
+    bool fresh = (st.st_size == 0);
+    size_t len;
+    if (fresh) {
+        len = VECTOR_MAP_HEADER_BYTES + VECTOR_MAP_INIT_CAP * sizeof(int);
+        if (ftruncate(fd, (off_t)len) != 0) {
+            close(fd);
+            return NULL;
+        }
+    }
+    else if ((uint64_t)st.st_size < VECTOR_MAP_HEADER_BYTES || (uint64_t)st.st_size > SIZE_MAX) {
+        close(fd);
+        return NULL;
+    }
+    else {
+        len = (size_t)st.st_size;
+    }
+
+    void *base = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        close(fd);
+        return NULL;
+    }
 
-vector *vector_new(void) {
     vector *v = (vector*)calloc(1, sizeof(*v));
     if (!v) {
+        munmap(base, len);
+        close(fd);
         return NULL;
     }
+    v->map_base = base;
+    v->map_len = len;
+    v->map_fd = fd;
+    v->data = (int*)((char*)base + VECTOR_MAP_HEADER_BYTES);
+
+    if (fresh) {
+        v->capacity = VECTOR_MAP_INIT_CAP;
+        vector_map_store_header(v);
+        return v;
+    }
     else {
-        v->capacity = 2;
-        v->data = (int*)malloc(v->capacity * sizeof(int));
-        if (!v->data) {
+        const vector_map_header *h = (const vector_map_header*)base;
+        size_t max_cap = (len - VECTOR_MAP_HEADER_BYTES) / sizeof(int);
+        if (h->magic != VECTOR_MAP_MAGIC || h->capacity == 0 || h->capacity > max_cap ||
+            h->head >= h->capacity || h->size > h->capacity) {
+            munmap(base, len);
+            close(fd);
             free(v);
             return NULL;
         }
         else {
-            /* size=0, head=0, tail=0 come from calloc */
+            v->capacity = (size_t)h->capacity;
+            v->head = (size_t)h->head;
+            v->size = (size_t)h->size;
+            v->tail = (v->size ? (v->head + v->size - 1) % v->capacity : v->head);
             return v;
         }
     }
+#else
+    (void)path;
+    (void)flags;
+    return NULL;
+#endif
 }
 
-void vector_free(vector *v) {
+int vector_sync(vector *v) {
     if (!v) {
-        return;
+        return VECTOR_ERR_RANGE;
     }
+#if VECTOR_HAVE_MMAP
+    else if (v->map_base) {
+        vector_map_store_header(v);
+        if (msync(v->map_base, v->map_len, MS_SYNC) != 0) {
+            return VECTOR_ERR_IO;
+        }
+        else {
+            return VECTOR_OK;
+        }
+    }
+#endif
     else {
-        free(v->data);
-        free(v);
-        return;
+        return VECTOR_OK; /* nothing to persist */
     }
 }
 
@@ -317,24 +1104,31 @@ int vector_insert(vector *v, size_t index, int value) {
         return vector_push_front(v, value);
     }
     else {
-        int rc;
         if (v->size == v->capacity) {
-            rc = vector_ensure_capacity(v, v->size + 1);
+            int rc = vector_ensure_capacity(v, v->size + 1);
             if (rc != VECTOR_OK) {
                 return rc;
             }
         }
-        rc = vector_linearize(v);
-        if (rc != VECTOR_OK) {
-            return rc;
-        }
 
-        /* head==0, tail==size-1, data[0..size-1] valid and contiguous */
-        size_t pos = index;
-        memmove(&v->data[pos + 1], &v->data[pos], (v->size - pos) * sizeof(int));
+        size_t cap = v->capacity;
+        size_t pos;
+        if (index < v->size - index) {
+            /* shift [0, index) one slot toward the front */
+            size_t new_head = (v->head == 0) ? (cap - 1) : (v->head - 1);
+            vector_ring_move(v, new_head, v->head, index, true);
+            v->head = new_head;
+            pos = (v->head + index) % cap;
+        }
+        else {
+            /* shift [index, size) one slot toward the back */
+            pos = (v->head + index) % cap;
+            size_t dst = (pos + 1 == cap) ? 0 : (pos + 1);
+            vector_ring_move(v, dst, pos, v->size - index, false);
+            v->tail = (v->tail + 1 == cap) ? 0 : (v->tail + 1);
+        }
         v->data[pos] = value;
         v->size++;
-        v->tail = v->size - 1;
         return VECTOR_OK;
     }
 }
@@ -356,54 +1150,594 @@ int vector_remove(vector *v, size_t index, int *out) {
         return vector_pop_back(v, out);
     }
     else {
-        int rc = vector_linearize(v);
+        size_t cap = v->capacity;
+        size_t pos = (v->head + index) % cap;
+        if (out) {
+            *out = v->data[pos];
+        }
+
+        if (index < v->size - index - 1) {
+            /* close the gap by shifting [0, index) one slot toward the back */
+            size_t new_head = (v->head + 1 == cap) ? 0 : (v->head + 1);
+            vector_ring_move(v, new_head, v->head, index, false);
+            v->head = new_head;
+        }
+        else {
+            /* close the gap by shifting (index, size) one slot toward the front */
+            size_t src = (pos + 1 == cap) ? 0 : (pos + 1);
+            vector_ring_move(v, pos, src, v->size - index - 1, true);
+            v->tail = (v->tail == 0) ? (cap - 1) : (v->tail - 1);
+        }
+        v->size--;
+        return VECTOR_OK;
+    }
+}
+
+int vector_push_back_n(vector *v, const int *src, size_t count) {
+    if (!v || (!src && count > 0)) {
+        return VECTOR_ERR_RANGE;
+    }
+    else if (count == 0) {
+        return VECTOR_OK;
+    }
+    else if (count > SIZE_MAX - v->size) {
+        return VECTOR_ERR_OOM;
+    }
+    else {
+        int rc = vector_ensure_capacity(v, v->size + count);
         if (rc != VECTOR_OK) {
             return rc;
         }
 
-        if (out) {
-            *out = v->data[index];
+        if (v->size == 0) {
+            v->head = 0;
         }
-        memmove(&v->data[index], &v->data[index + 1], (v->size - index - 1) * sizeof(int));
-        v->size--;
-        v->tail = v->size - 1;
+        size_t pos = (v->head + v->size) % v->capacity;
+        vector_ring_write(v, pos, src, count);
+        v->size += count;
+        v->tail = (v->head + v->size - 1) % v->capacity;
         return VECTOR_OK;
     }
 }
 
-int vector_search(const vector *v, int value, size_t *out_index) {
+int vector_push_front_n(vector *v, const int *src, size_t count) {
+    if (!v || (!src && count > 0)) {
+        return VECTOR_ERR_RANGE;
+    }
+    else if (count == 0) {
+        return VECTOR_OK;
+    }
+    else if (count > SIZE_MAX - v->size) {
+        return VECTOR_ERR_OOM;
+    }
+    else {
+        int rc = vector_ensure_capacity(v, v->size + count);
+        if (rc != VECTOR_OK) {
+            return rc;
+        }
+
+        if (v->size == 0) {
+            v->head = 0;
+        }
+        size_t pos = (v->head + v->capacity - count) % v->capacity;
+        vector_ring_write(v, pos, src, count);
+        v->head = pos;
+        v->size += count;
+        v->tail = (v->head + v->size - 1) % v->capacity;
+        return VECTOR_OK;
+    }
+}
+
+int vector_copy_out(const vector *v, size_t start, size_t count, int *dst) {
+    if (!v || (!dst && count > 0)) {
+        return VECTOR_ERR_RANGE;
+    }
+    else if (start > v->size || count > v->size - start) {
+        return VECTOR_ERR_RANGE;
+    }
+    else if (count == 0) {
+        return VECTOR_OK;
+    }
+    else {
+        vector_ring_read(v, (v->head + start) % v->capacity, count, dst);
+        return VECTOR_OK;
+    }
+}
+
+int vector_pop_front_n(vector *v, size_t count, int *dst) {
+    if (!v) {
+        return VECTOR_ERR_RANGE;
+    }
+    else if (count > v->size) {
+        return (v->size == 0) ? VECTOR_ERR_EMPTY : VECTOR_ERR_RANGE;
+    }
+    else if (count == 0) {
+        return VECTOR_OK;
+    }
+    else {
+        if (dst) {
+            vector_ring_read(v, v->head, count, dst);
+        }
+        v->head = (v->head + count) % v->capacity;
+        v->size -= count;
+        if (v->size == 0) {
+            v->head = 0;
+            v->tail = 0;
+        }
+        else {
+            /* tail remains valid */
+        }
+        return VECTOR_OK;
+    }
+}
+
+/* ---- Views -------------------------------------------------------------- */
+
+void vector_spans(const vector *v, const int **a, size_t *alen,
+                  const int **b, size_t *blen) {
+    int *ma = NULL;
+    int *mb = NULL;
+    vector_spans_mut((vector*)v, &ma, alen, &mb, blen);
+    if (a) {
+        *a = ma;
+    }
+    if (b) {
+        *b = mb;
+    }
+}
+
+void vector_spans_mut(vector *v, int **a, size_t *alen, int **b, size_t *blen) {
+    int   *pa = NULL;
+    int   *pb = NULL;
+    size_t na = 0;
+    size_t nb = 0;
+
     if (!v || v->size == 0) {
-        return VECTOR_ERR_NOTFOUND;
+        /* both spans empty */
+    }
+    else if (v->head + v->size <= v->capacity) {
+        pa = &v->data[v->head];
+        na = v->size;
+    }
+    else {
+        pa = &v->data[v->head];
+        na = v->capacity - v->head;
+        pb = v->data;
+        nb = v->size - na;
+    }
+
+    if (a) {
+        *a = pa;
+    }
+    if (alen) {
+        *alen = na;
     }
-    else if (v->head <= v->tail) {
-        for (size_t i = v->head; i <= v->tail; ++i) {
-            if (v->data[i] == value) {
-                if (out_index) {
-                    *out_index = i - v->head;
+    if (b) {
+        *b = pb;
+    }
+    if (blen) {
+        *blen = nb;
+    }
+}
+
+int vector_make_contiguous(vector *v, int **out_data) {
+    if (!v) {
+        return VECTOR_ERR_RANGE;
+    }
+    else {
+        if (v->size == 0) {
+            v->head = 0;
+            v->tail = 0;
+        }
+        else if (v->head + v->size <= v->capacity) {
+            /* single segment: slide it down to index 0 */
+            memmove(v->data, &v->data[v->head], v->size * sizeof(int));
+        }
+        else {
+            /* layout [B .. gap .. A]: close the gap, then rotate [B A] into [A B] */
+            size_t a = v->capacity - v->head;
+            size_t b = v->size - a;
+            memmove(&v->data[b], &v->data[v->head], a * sizeof(int));
+            vector_reverse(v->data, b);
+            vector_reverse(&v->data[b], a);
+            vector_reverse(v->data, v->size);
+        }
+        v->head = 0;
+        v->tail = (v->size ? (v->size - 1) : 0);
+        if (out_data) {
+            *out_data = v->data;
+        }
+        return VECTOR_OK;
+    }
+}
+
+/* ---- Bulk removal ------------------------------------------------------- */
+
+/* Drops the elements of the tail after a compaction left `kept` survivors. */
+static void vector_truncate_to(vector *v, size_t kept) {
+    v->size = kept;
+    if (kept == 0) {
+        v->head = 0;
+        v->tail = 0;
+    }
+    else {
+        v->tail = (v->head + kept - 1) % v->capacity;
+    }
+}
+
+size_t vector_remove_if(vector *v, vector_pred_fn pred, void *ctx) {
+    if (!v || !pred || v->size == 0) {
+        return 0;
+    }
+    else {
+        const int *seg[2];
+        size_t     len[2];
+        vector_spans(v, &seg[0], &len[0], &seg[1], &len[1]);
+
+        /* survivors are written back in order behind the read cursor */
+        size_t cap = v->capacity;
+        size_t w = v->head;
+        size_t kept = 0;
+        for (int s = 0; s < 2; ++s) {
+            const int *p = seg[s];
+            for (size_t i = 0; i < len[s]; ++i) {
+                int x = p[i];
+                if (!pred(x, ctx)) {
+                    v->data[w] = x;
+                    w = (w + 1 == cap) ? 0 : (w + 1);
+                    kept++;
                 }
-                return VECTOR_OK;
             }
-            else {
-                /* continue scanning */
+        }
+
+        size_t removed = v->size - kept;
+        vector_truncate_to(v, kept);
+        return removed;
+    }
+}
+
+size_t vector_remove_value(vector *v, int value) {
+    size_t first;
+    if (vector_search(v, value, &first) != VECTOR_OK) {
+        return 0;
+    }
+    else {
+        /* everything before the first match stays put; compact from there */
+        size_t cap = v->capacity;
+        size_t r = (v->head + first) % cap;
+        size_t w = r;
+        size_t kept = first;
+        for (size_t i = first; i < v->size; ++i) {
+            int x = v->data[r];
+            if (x != value) {
+                v->data[w] = x;
+                w = (w + 1 == cap) ? 0 : (w + 1);
+                kept++;
             }
+            r = (r + 1 == cap) ? 0 : (r + 1);
         }
+
+        size_t removed = v->size - kept;
+        vector_truncate_to(v, kept);
+        return removed;
+    }
+}
+
+int vector_remove_range(vector *v, size_t from, size_t to) {
+    if (!v) {
+        return VECTOR_ERR_RANGE;
+    }
+    else if (from > to || to > v->size) {
+        return VECTOR_ERR_RANGE;
+    }
+    else if (from == to) {
+        return VECTOR_OK;
+    }
+    else {
+        size_t cap = v->capacity;
+        size_t k = to - from;
+        if (from < v->size - to) {
+            /* slide [0, from) toward the back by k */
+            size_t new_head = (v->head + k) % cap;
+            vector_ring_move(v, new_head, v->head, from, false);
+            v->head = new_head;
+            v->size -= k;
+            if (v->size == 0) {
+                v->head = 0;
+                v->tail = 0;
+            }
+        }
+        else {
+            /* slide [to, size) toward the front by k */
+            size_t dst = (v->head + from) % cap;
+            size_t src = (v->head + to) % cap;
+            vector_ring_move(v, dst, src, v->size - to, true);
+            vector_truncate_to(v, v->size - k);
+        }
+        return VECTOR_OK;
+    }
+}
+
+int vector_search(const vector *v, int value, size_t *out_index) {
+    if (!v || v->size == 0) {
         return VECTOR_ERR_NOTFOUND;
     }
     else {
-        for (size_t i = 0; i < v->size; ++i) {
-            size_t pos = (v->head + i) % v->capacity;
-            if (v->data[pos] == value) {
-                if (out_index) {
-                    *out_index = i;
+        const int *a;
+        const int *b;
+        size_t na;
+        size_t nb;
+        vector_spans(v, &a, &na, &b, &nb);
+
+        size_t i = vector_find_kernel(a, na, value);
+        if (i == na && nb > 0) {
+            i = na + vector_find_kernel(b, nb, value);
+        }
+        if (i == v->size) {
+            return VECTOR_ERR_NOTFOUND;
+        }
+        else {
+            if (out_index) {
+                *out_index = i;
+            }
+            return VECTOR_OK;
+        }
+    }
+}
+
+size_t vector_count(const vector *v, int value) {
+    if (!v || v->size == 0) {
+        return 0;
+    }
+    else {
+        const int *a;
+        const int *b;
+        size_t na;
+        size_t nb;
+        vector_spans(v, &a, &na, &b, &nb);
+        return vector_count_kernel(a, na, value) + vector_count_kernel(b, nb, value);
+    }
+}
+
+size_t vector_find_all(const vector *v, int value, size_t *out_idx, size_t max) {
+    if (!v || v->size == 0 || !out_idx || max == 0) {
+        return 0;
+    }
+    else {
+        const int *seg[2];
+        size_t     len[2];
+        vector_spans(v, &seg[0], &len[0], &seg[1], &len[1]);
+
+        size_t found = 0;
+        size_t base = 0;
+        for (int s = 0; s < 2 && found < max; ++s) {
+            size_t i = 0;
+            while (i < len[s] && found < max) {
+                i += vector_find_kernel(seg[s] + i, len[s] - i, value);
+                if (i < len[s]) {
+                    out_idx[found++] = base + i;
+                    ++i;
                 }
-                return VECTOR_OK;
             }
-            else {
-                /* continue scanning */
+            base += len[s];
+        }
+        return found;
+    }
+}
+
+/* ---- Aggregates and transforms ---------------------------------------- */
+
+int64_t vector_sum(const vector *v) {
+    if (!v || v->size == 0) {
+        return 0;
+    }
+    else {
+        const int *a;
+        const int *b;
+        size_t na;
+        size_t nb;
+        vector_spans(v, &a, &na, &b, &nb);
+        return vector_sum_kernel(a, na) + vector_sum_kernel(b, nb);
+    }
+}
+
+int vector_min_max(const vector *v, int *out_min, int *out_max) {
+    if (!v || v->size == 0) {
+        return VECTOR_ERR_EMPTY;
+    }
+    else {
+        const int *a;
+        const int *b;
+        size_t na;
+        size_t nb;
+        vector_spans(v, &a, &na, &b, &nb);
+
+        int lo = a[0];
+        int hi = a[0];
+        vector_min_max_kernel(a, na, &lo, &hi);
+        vector_min_max_kernel(b, nb, &lo, &hi);
+        if (out_min) {
+            *out_min = lo;
+        }
+        if (out_max) {
+            *out_max = hi;
+        }
+        return VECTOR_OK;
+    }
+}
+
+int vector_fill(vector *v, int value) {
+    if (!v) {
+        return VECTOR_ERR_RANGE;
+    }
+    else {
+        int *a;
+        int *b;
+        size_t na;
+        size_t nb;
+        vector_spans_mut(v, &a, &na, &b, &nb);
+        vector_fill_kernel(a, na, value);
+        vector_fill_kernel(b, nb, value);
+        return VECTOR_OK;
+    }
+}
+
+int vector_add_scalar(vector *v, int delta) {
+    if (!v) {
+        return VECTOR_ERR_RANGE;
+    }
+    else {
+        int *a;
+        int *b;
+        size_t na;
+        size_t nb;
+        vector_spans_mut(v, &a, &na, &b, &nb);
+        vector_add_scalar_kernel(a, na, delta);
+        vector_add_scalar_kernel(b, nb, delta);
+        return VECTOR_OK;
+    }
+}
+
+int vector_map(vector *v, vector_map_fn fn, void *ctx) {
+    if (!v || !fn) {
+        return VECTOR_ERR_RANGE;
+    }
+    else {
+        int   *seg[2];
+        size_t len[2];
+        vector_spans_mut(v, &seg[0], &len[0], &seg[1], &len[1]);
+        for (int s = 0; s < 2; ++s) {
+            int *p = seg[s];
+            for (size_t i = 0; i < len[s]; ++i) {
+                p[i] = fn(p[i], ctx);
             }
         }
-        return VECTOR_ERR_NOTFOUND;
+        return VECTOR_OK;
+    }
+}
+
+/* ---- Sorting ------------------------------------------------------------ */
+
+int vector_sort(vector *v) {
+    if (!v) {
+        return VECTOR_ERR_RANGE;
+    }
+    else if (v->size < 2) {
+        return VECTOR_OK;
+    }
+    else {
+        int *data;
+        (void)vector_make_contiguous(v, &data);
+        if (v->size < VECTOR_SORT_SMALL) {
+            vector_insertion_sort(data, v->size);
+            return VECTOR_OK;
+        }
+
+        int *tmp = (int*)malloc(v->size * sizeof(int));
+        if (!tmp) {
+            return VECTOR_ERR_OOM;
+        }
+        else {
+            vector_radix_sort(data, tmp, v->size);
+            free(tmp);
+            return VECTOR_OK;
+        }
+    }
+}
+
+int vector_sort_parallel(vector *v, unsigned nthreads) {
+#if VECTOR_HAVE_PTHREADS
+    if (!v) {
+        return VECTOR_ERR_RANGE;
+    }
+    else {
+        size_t n = v->size;
+        size_t parts = nthreads;
+        if (parts > n / VECTOR_SORT_MIN_CHUNK) {
+            parts = n / VECTOR_SORT_MIN_CHUNK;
+        }
+        if (parts < 2) {
+            return vector_sort(v);
+        }
+
+        int *data;
+        (void)vector_make_contiguous(v, &data);
+
+        int             *tmp     = (int*)malloc(n * sizeof(int));
+        vector_sort_job *jobs    = (vector_sort_job*)malloc(parts * sizeof(*jobs));
+        size_t          *bounds  = (size_t*)malloc((parts + 1) * sizeof(size_t));
+        pthread_t       *tids    = (pthread_t*)malloc(parts * sizeof(pthread_t));
+        bool            *started = (bool*)malloc(parts * sizeof(bool));
+        if (!tmp || !jobs || !bounds || !tids || !started) {
+            free(tmp);
+            free(jobs);
+            free(bounds);
+            free(tids);
+            free(started);
+            return VECTOR_ERR_OOM;
+        }
+
+        /* phase 1: radix-sort equal slices independently */
+        for (size_t i = 0; i <= parts; ++i) {
+            bounds[i] = n / parts * i + (i * (n % parts)) / parts;
+        }
+        for (size_t i = 0; i < parts; ++i) {
+            jobs[i].src = data;
+            jobs[i].dst = tmp;
+            jobs[i].lo = bounds[i];
+            jobs[i].mid = 0;
+            jobs[i].hi = bounds[i + 1];
+            jobs[i].merge = false;
+        }
+        vector_run_jobs(jobs, tids, started, parts);
+
+        /* phase 2: merge adjacent runs pairwise, ping-ponging between buffers */
+        int *src = data;
+        int *dst = tmp;
+        size_t runs = parts;
+        while (runs > 1) {
+            size_t njobs = 0;
+            size_t kept = 0;
+            for (size_t r = 0; r < runs; r += 2) {
+                if (r + 1 < runs) {
+                    jobs[njobs].src = src;
+                    jobs[njobs].dst = dst;
+                    jobs[njobs].lo = bounds[r];
+                    jobs[njobs].mid = bounds[r + 1];
+                    jobs[njobs].hi = bounds[r + 2];
+                    jobs[njobs].merge = true;
+                    njobs++;
+                }
+                else {
+                    /* odd run out: carry it over unchanged */
+                    memcpy(&dst[bounds[r]], &src[bounds[r]],
+                           (bounds[r + 1] - bounds[r]) * sizeof(int));
+                }
+                bounds[kept++] = bounds[r];
+            }
+            bounds[kept] = n;
+            vector_run_jobs(jobs, tids, started, njobs);
+
+            int *t = src;
+            src = dst;
+            dst = t;
+            runs = kept;
+        }
+
+        if (src != data) {
+            memcpy(data, src, n * sizeof(int));
+        }
+        free(tmp);
+        free(jobs);
+        free(bounds);
+        free(tids);
+        free(started);
+        return VECTOR_OK;
     }
+#else
+    (void)nthreads;
+    return vector_sort(v);
+#endif
 }
 
 /* ---- Debug -------------------------------------------------------------- */
@@ -0,0 +1,238 @@
+#include "vector_spsc.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+/* Counter access. C11 atomics everywhere except MSVC, whose <stdatomic.h>
+   only works under /experimental:c11atomics: there the counters are
+   volatile words, ordered by a compiler barrier on x86/x64 (plain loads
+   and stores already acquire/release) or a dmb on ARM. */
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+typedef volatile size_t spsc_counter;
+#if defined(_M_ARM64)
+#define SPSC_FENCE() __dmb(_ARM64_BARRIER_ISH)
+#elif defined(_M_ARM)
+#define SPSC_FENCE() __dmb(_ARM_BARRIER_ISH)
+#else
+#define SPSC_FENCE() _ReadWriteBarrier()
+#endif
+static size_t spsc_load_acquire(spsc_counter *c) {
+    size_t v = *c;
+    SPSC_FENCE();
+    return v;
+}
+static void spsc_store_release(spsc_counter *c, size_t v) {
+    SPSC_FENCE();
+    *c = v;
+}
+#define SPSC_INIT(c, v)          (*(c) = (v))
+#define SPSC_LOAD_RELAXED(c)     (*(c))
+#define SPSC_LOAD_ACQUIRE(c)     spsc_load_acquire(c)
+#define SPSC_STORE_RELEASE(c, v) spsc_store_release((c), (v))
+#else
+#include <stdatomic.h>
+typedef atomic_size_t spsc_counter;
+#define SPSC_INIT(c, v)          atomic_init((c), (v))
+#define SPSC_LOAD_RELAXED(c)     atomic_load_explicit((c), memory_order_relaxed)
+#define SPSC_LOAD_ACQUIRE(c)     atomic_load_explicit((c), memory_order_acquire)
+#define SPSC_STORE_RELEASE(c, v) atomic_store_explicit((c), (v), memory_order_release)
+#endif
+
+/* Layout:
+   - head and tail are free-running counters (never wrapped); the physical
+     slot is counter & mask, and tail - head is the current size.
+   - The producer owns tail, the consumer owns head. Each side keeps a
+     private cached copy of the other side's counter and only reloads it
+     (an acquire load that may miss in cache) when the cache says the ring
+     looks full/empty.
+   - Producer fields, consumer fields and the read-only configuration each
+     sit on their own cache line to avoid false sharing. */
+
+#define SPSC_CACHE_LINE 64
+
+struct vector_spsc {
+    /* producer side */
+    _Alignas(SPSC_CACHE_LINE) spsc_counter tail;
+    size_t head_cache;
+
+    /* consumer side */
+    _Alignas(SPSC_CACHE_LINE) spsc_counter head;
+    size_t tail_cache;
+
+    /* immutable after construction */
+    _Alignas(SPSC_CACHE_LINE) size_t mask;
+    size_t capacity;
+    int   *data;
+    void  *raw;         /* allocation backing this struct */
+};
+
+/* ---- internal helpers --------------------------------------------------- */
+
+static size_t spsc_round_pow2(size_t x) {
+    size_t p = 1;
+    while (p < x) {
+        if (p > (SIZE_MAX / 2)) {
+            return 0;
+        }
+        else {
+            p <<= 1;
+        }
+    }
+    return p;
+}
+
+/* Copies count ints into the ring at counter position pos (two segments at most). */
+static void spsc_write(vector_spsc *q, size_t pos, const int *src, size_t count) {
+    size_t i = pos & q->mask;
+    size_t first = q->capacity - i;
+    if (first > count) {
+        first = count;
+    }
+    memcpy(&q->data[i], src, first * sizeof(int));
+    memcpy(q->data, src + first, (count - first) * sizeof(int));
+}
+
+static void spsc_read(const vector_spsc *q, size_t pos, int *dst, size_t count) {
+    size_t i = pos & q->mask;
+    size_t first = q->capacity - i;
+    if (first > count) {
+        first = count;
+    }
+    memcpy(dst, &q->data[i], first * sizeof(int));
+    memcpy(dst + first, q->data, (count - first) * sizeof(int));
+}
+
+/* ---- Lifecycle ---------------------------------------------------------- */
+
+vector_spsc *vector_spsc_new(size_t capacity) {
+    size_t cap = spsc_round_pow2(capacity ? capacity : 1);
+    if (cap == 0 || cap > SIZE_MAX / sizeof(int)) {
+        return NULL;
+    }
+
+    /* aligned by hand: aligned_alloc is missing from MSVC's C runtime */
+    void *raw = malloc(sizeof(vector_spsc) + SPSC_CACHE_LINE - 1);
+    if (!raw) {
+        return NULL;
+    }
+    else {
+        uintptr_t p = ((uintptr_t)raw + SPSC_CACHE_LINE - 1) & ~(uintptr_t)(SPSC_CACHE_LINE - 1);
+        vector_spsc *q = (vector_spsc*)p;
+        q->raw = raw;
+        q->data = (int*)malloc(cap * sizeof(int));
+        if (!q->data) {
+            free(raw);
+            return NULL;
+        }
+        else {
+            SPSC_INIT(&q->tail, 0);
+            SPSC_INIT(&q->head, 0);
+            q->head_cache = 0;
+            q->tail_cache = 0;
+            q->mask = cap - 1;
+            q->capacity = cap;
+            return q;
+        }
+    }
+}
+
+void vector_spsc_free(vector_spsc *q) {
+    if (!q) {
+        return;
+    }
+    else {
+        free(q->data);
+        free(q->raw);
+        return;
+    }
+}
+
+/* ---- Queries ------------------------------------------------------------ */
+
+size_t vector_spsc_capacity(const vector_spsc *q) {
+    if (!q) {
+        return 0;
+    }
+    else {
+        return q->capacity;
+    }
+}
+
+size_t vector_spsc_size(const vector_spsc *q) {
+    if (!q) {
+        return 0;
+    }
+    else {
+        /* load head first so a concurrent push cannot make tail - head negative */
+        size_t h = SPSC_LOAD_ACQUIRE(&((vector_spsc*)q)->head);
+        size_t t = SPSC_LOAD_ACQUIRE(&((vector_spsc*)q)->tail);
+        return t - h;
+    }
+}
+
+/* ---- Producer ----------------------------------------------------------- */
+
+int vector_spsc_push_back(vector_spsc *q, int value) {
+    return (vector_spsc_push_back_n(q, &value, 1) == 1) ? VECTOR_OK : VECTOR_ERR_FULL;
+}
+
+size_t vector_spsc_push_back_n(vector_spsc *q, const int *src, size_t count) {
+    if (!q || !src || count == 0) {
+        return 0;
+    }
+    else {
+        size_t t = SPSC_LOAD_RELAXED(&q->tail);
+        size_t space = q->capacity - (t - q->head_cache);
+        if (space < count) {
+            q->head_cache = SPSC_LOAD_ACQUIRE(&q->head);
+            space = q->capacity - (t - q->head_cache);
+        }
+        if (count > space) {
+            count = space;
+        }
+        if (count > 0) {
+            spsc_write(q, t, src, count);
+            SPSC_STORE_RELEASE(&q->tail, t + count);
+        }
+        return count;
+    }
+}
+
+/* ---- Consumer ----------------------------------------------------------- */
+
+int vector_spsc_pop_front(vector_spsc *q, int *out) {
+    int tmp;
+    if (vector_spsc_pop_front_n(q, &tmp, 1) == 1) {
+        if (out) {
+            *out = tmp;
+        }
+        return VECTOR_OK;
+    }
+    else {
+        return VECTOR_ERR_EMPTY;
+    }
+}
+
+size_t vector_spsc_pop_front_n(vector_spsc *q, int *dst, size_t max) {
+    if (!q || !dst || max == 0) {
+        return 0;
+    }
+    else {
+        size_t h = SPSC_LOAD_RELAXED(&q->head);
+        size_t avail = q->tail_cache - h;
+        if (avail < max) {
+            q->tail_cache = SPSC_LOAD_ACQUIRE(&q->tail);
+            avail = q->tail_cache - h;
+        }
+        if (max > avail) {
+            max = avail;
+        }
+        if (max > 0) {
+            spsc_read(q, h, dst, max);
+            SPSC_STORE_RELEASE(&q->head, h + max);
+        }
+        return max;
+    }
+}